@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ball-kinematics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Longest integration step of accelerated balls in seconds.
+constexpr float MAX_SUBSTEP{0.001f};
+
+void advanceAtConstantSpeed(const BallSpec &spec, SweepState &state, float dt) noexcept
+{
+    // Whole back-and-forth cycles end where they started.
+    float distance = std::fmod(spec.speed * dt, 2.0f * (spec.sweepMax - spec.sweepMin));
+    while (distance > 0.0f) {
+        float const limit = (state.direction > 0.0f) ? spec.sweepMax : spec.sweepMin;
+        float const toLimit = (limit - state.s) * state.direction;
+        if ( distance < toLimit ){
+            state.s += state.direction * distance;
+            distance = 0.0f;
+        }
+        else{
+            state.s = limit;
+            distance -= std::max(toLimit, 0.0f);
+            state.direction = -state.direction;
+        }
+    }
+    state.v = state.direction * spec.speed;
+}
+
+void advanceAccelerated(const BallSpec &spec, SweepState &state, float dt) noexcept
+{
+    uint32_t const substeps = std::max<uint32_t>(1, static_cast<uint32_t>(std::ceil(dt / MAX_SUBSTEP)));
+    float const h = dt / static_cast<float>(substeps);
+    float const maxChange = spec.acceleration * h;
+    for (uint32_t i = 0; i < substeps; i++) {
+        float const limit = (state.direction > 0.0f) ? spec.sweepMax : spec.sweepMin;
+        float const toLimit = (limit - state.s) * state.direction;
+        float const speed = state.v * state.direction;
+
+        // Brake once the braking distance reaches the limit, otherwise approach the cruise speed.
+        bool const isBraking = speed > 0.0f && speed * speed >= 2.0f * spec.acceleration * toLimit;
+        float const target = isBraking ? 0.0f : spec.speed;
+        float const nextSpeed = speed + std::min(std::max(target - speed, -maxChange), maxChange);
+        state.s += state.direction * 0.5f * (speed + nextSpeed) * h;
+
+        if ( (limit - state.s) * state.direction <= 0.0f || (isBraking && nextSpeed <= 0.0f) ){
+            state.s = ((limit - state.s) * state.direction <= 0.0f) ? limit : state.s;
+            state.v = 0.0f;
+            state.direction = -state.direction;
+        }
+        else{
+            state.v = state.direction * nextSpeed;
+        }
+    }
+}
+} // namespace
+
+SweepState initialSweep(const BallSpec &spec) noexcept
+{
+    float const direction = (spec.start >= spec.sweepMax) ? -1.0f : 1.0f;
+    return SweepState{spec.start, (spec.acceleration > 0.0f) ? 0.0f : direction * spec.speed, direction};
+}
+
+void advanceSweep(const BallSpec &spec, SweepState &state, float dt) noexcept
+{
+    if ( dt <= 0.0f ){
+        return;
+    }
+    if ( spec.acceleration > 0.0f ){
+        advanceAccelerated(spec, state, dt);
+    }
+    else{
+        advanceAtConstantSpeed(spec, state, dt);
+    }
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BALL_KINEMATICS_HPP
+#define BALL_KINEMATICS_HPP
+
+#include "scenario.hpp"
+
+/**
+ * Motion of a ball along its sweep coordinate s between the spec's limits.
+ */
+struct SweepState {
+    float s;
+    // Signed velocity along the sweep in m/s.
+    float v;
+    // +1 or -1, the limit the ball is heading for.
+    float direction;
+};
+
+SweepState initialSweep(const BallSpec &spec) noexcept;
+
+/**
+ * Moves the ball by dt seconds. Without acceleration it travels at the
+ * spec's speed and reverses exactly at the limits, also in the middle of a
+ * tick; with acceleration it speeds up to that speed, brakes in time to stop
+ * at the limit and turns around, integrated in steps of at most 1 ms.
+ */
+void advanceSweep(const BallSpec &spec, SweepState &state, float dt) noexcept;
+
+#endif
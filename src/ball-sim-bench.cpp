@@ -0,0 +1,890 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "allocation-counter.hpp"
+#include "ball-simulator-messages.hpp"
+#include "cluon-complete.hpp"
+#include "distance-kernel.hpp"
+#include "entity-states.hpp"
+#include "envelope-encoder.hpp"
+#include "envelope-filter.hpp"
+#include "episode.hpp"
+#include "opendlv-standard-message-set.hpp"
+#include "scenario.hpp"
+#include "shm-ring.hpp"
+#include "target-grid.hpp"
+#include "world.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+// Session used for the OD4Session round trip; keep it clear of running simulators.
+constexpr uint16_t OD4_BENCH_CID{250};
+
+// One measurement of the JSON report, named like Google Benchmark's "family/arg:value".
+struct BenchmarkResult {
+    std::string name;
+    uint64_t iterations;
+    double realTime;
+    double cpuTime;
+    std::string timeUnit;
+    // Heap allocations per iteration, negative if not measured.
+    double allocations;
+};
+
+std::vector<BenchmarkResult> &results() {
+    static std::vector<BenchmarkResult> all;
+    return all;
+}
+
+// Runs body repeatedly for at least 200 ms and returns nanoseconds per run.
+template <typename F>
+double measure(const std::string &name, F &&body) {
+    uint64_t iterations{0};
+    std::clock_t const cpuStart = std::clock();
+    auto const start = std::chrono::steady_clock::now();
+    auto now = start;
+    do {
+        for (uint32_t i = 0; i < 64; i++) {
+            body();
+        }
+        iterations += 64;
+        now = std::chrono::steady_clock::now();
+    } while (now - start < std::chrono::milliseconds(200));
+    double const cpuTime = 1.0e9 * static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    std::chrono::duration<double, std::nano> const elapsed = now - start;
+    double const perRun = elapsed.count() / static_cast<double>(iterations);
+    results().push_back(BenchmarkResult{name, iterations, perRun, cpuTime / static_cast<double>(iterations), "ns", -1.0});
+    return perRun;
+}
+
+// Heap allocations per run of body, after one warm-up run; attached to the result of the same name.
+template <typename F>
+double allocationsPerRun(const std::string &name, F &&body) {
+    body();
+    uint64_t const before = heapAllocations();
+    for (uint32_t i = 0; i < 1000; i++) {
+        body();
+    }
+    double const allocations = static_cast<double>(heapAllocations() - before) / 1000.0;
+    for (auto &result : results()) {
+        if ( result.name == name ){
+            result.allocations = allocations;
+        }
+    }
+    return allocations;
+}
+
+// Latencies are reported as the median round trip; the caller's thread mostly waits.
+void addLatency(const std::string &name, uint32_t rounds, double medianInMicroseconds) {
+    if ( medianInMicroseconds < 0.0 ){
+        return;
+    }
+    results().push_back(BenchmarkResult{name, rounds, medianInMicroseconds, medianInMicroseconds, "us", -1.0});
+}
+
+// String as a JSON string literal, quotes included.
+std::string jsonString(const std::string &value) {
+    std::stringstream sstr;
+    sstr << '"';
+    for (char const c : value) {
+        if ( '"' == c || '\\' == c ){
+            sstr << '\\' << c;
+        }
+        else if ( static_cast<unsigned char>(c) < 0x20 ){
+            sstr << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+        }
+        else{
+            sstr << c;
+        }
+    }
+    sstr << '"';
+    return sstr.str();
+}
+
+// Writes all results in the JSON layout of Google Benchmark's --benchmark_out.
+bool writeJson(const std::string &filename, const std::string &executable) {
+    std::ofstream out{filename};
+    if ( !out.good() ){
+        return false;
+    }
+    char hostName[256]{};
+    ::gethostname(hostName, sizeof(hostName) - 1);
+    std::time_t const now = std::time(nullptr);
+    std::tm local{};
+    ::localtime_r(&now, &local);
+    char date[32]{};
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", &local);
+
+    out << std::setprecision(9);
+    out << "{" << std::endl
+        << "  \"context\": {" << std::endl
+        << "    \"date\": \"" << date << "\"," << std::endl
+        << "    \"host_name\": " << jsonString(hostName) << "," << std::endl
+        << "    \"executable\": " << jsonString(executable) << "," << std::endl
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << "," << std::endl
+        << "    \"distance_kernel\": \"" << distanceKernelName() << "\"," << std::endl
+        << "    \"library_build_type\": \"release\"" << std::endl
+        << "  }," << std::endl
+        << "  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results().size(); i++) {
+        BenchmarkResult const &result = results()[i];
+        out << (i == 0 ? "" : ",") << std::endl
+            << "    {" << std::endl
+            << "      \"name\": " << jsonString(result.name) << "," << std::endl
+            << "      \"run_name\": " << jsonString(result.name) << "," << std::endl
+            << "      \"run_type\": \"iteration\"," << std::endl
+            << "      \"iterations\": " << result.iterations << "," << std::endl
+            << "      \"real_time\": " << result.realTime << "," << std::endl
+            << "      \"cpu_time\": " << result.cpuTime << "," << std::endl;
+        if ( result.allocations >= 0.0 ){
+            out << "      \"allocations_per_iteration\": " << result.allocations << "," << std::endl;
+        }
+        out << "      \"time_unit\": \"" << result.timeUnit << "\"" << std::endl
+            << "    }";
+    }
+    out << std::endl << "  ]" << std::endl << "}" << std::endl;
+    return out.good();
+}
+
+// Envelope as OD4Session::send builds it.
+template <typename T>
+std::string encodeWithCluon(T &message, const cluon::data::TimeStamp &sent, uint32_t senderStamp) {
+    cluon::ToProtoVisitor protoEncoder;
+    message.accept(protoEncoder);
+    cluon::data::Envelope envelope;
+    envelope.dataType(static_cast<int32_t>(message.ID()));
+    envelope.serializedData(protoEncoder.encodedData());
+    envelope.sent(sent);
+    envelope.sampleTimeStamp(sent);
+    envelope.senderStamp(senderStamp);
+    return cluon::serializeEnvelope(std::move(envelope));
+}
+
+template <typename T, typename PayloadEncoder>
+bool compareEncoders(const char *name, T &message, PayloadEncoder encodePayloadOf, std::size_t payloadCapacity) {
+    cluon::data::TimeStamp const sent = cluon::time::now();
+    std::vector<char> buffer;
+    buffer.reserve(4096);
+    std::vector<char> payload(payloadCapacity);
+    auto encode = [&](){
+        buffer.clear();
+        std::size_t const payloadSize = encodePayloadOf(payload.data());
+        appendEnvelope(buffer, static_cast<int32_t>(message.ID()), payload.data(), payloadSize, sent, sent, 3);
+    };
+
+    std::string const cluonName{std::string("encode/cluon/") + name};
+    std::string const encoderName{std::string("encode/encoder/") + name};
+    std::size_t bytes{0};
+    double const cluonTime = measure(cluonName, [&](){ bytes += encodeWithCluon(message, sent, 3).size(); });
+    double const cluonAllocations = allocationsPerRun(cluonName, [&](){ bytes += encodeWithCluon(message, sent, 3).size(); });
+    double const encoderTime = measure(encoderName, encode);
+    double const encoderAllocations = allocationsPerRun(encoderName, encode);
+
+    encode();
+    bool const isIdentical{encodeWithCluon(message, sent, 3) == std::string(buffer.begin(), buffer.end())};
+    std::cout << std::setw(18) << name << std::fixed << std::setprecision(1)
+              << std::setw(12) << cluonTime << std::setw(12) << cluonAllocations
+              << std::setw(12) << encoderTime << std::setw(12) << encoderAllocations
+              << std::setw(12) << (isIdentical ? "yes" : "NO") << std::endl;
+    if ( bytes == 0 ){
+        std::cout << " (no bytes)" << std::endl;
+    }
+    return isIdentical && encoderAllocations <= 0.0;
+}
+
+// Messages the encoder handles through encodePayload().
+template <typename T>
+bool compareEncoders(const char *name, T &message) {
+    return compareEncoders(name, message, [&message](char *out){ return encodePayload(message, out); }, MAX_FIXED_PAYLOAD_SIZE);
+}
+
+// Encodes every message type with cluon and with envelope-encoder; false if an
+// encoding differs or the encoder allocates (--check, run by ctest).
+bool checkEncoders() {
+    bool isValid{true};
+    std::cout << std::endl << "Envelope encoding per message (ns and heap allocations per message)" << std::endl;
+    std::cout << std::setw(18) << "message" << std::setw(12) << "cluon" << std::setw(12) << "allocs"
+              << std::setw(12) << "encoder" << std::setw(12) << "allocs" << std::setw(12) << "identical" << std::endl;
+    opendlv::sim::Frame frame;
+    frame.x(1.25f).y(-0.7f).z(1.5f);
+    isValid &= compareEncoders("Frame", frame);
+    opendlv::sim::KinematicState kinematicState;
+    kinematicState.vx(0.6f).vy(-0.8f);
+    isValid &= compareEncoders("KinematicState", kinematicState);
+    opendlv::logic::sensation::TargetFoundState state;
+    state.target_found_count(300).is_chpad_found(1);
+    isValid &= compareEncoders("TargetFoundState", state);
+    std::string const pathData(10 * 3 * sizeof(float), '\x3f');
+    opendlv::logic::action::LocalPath path;
+    path.length(10).data(pathData);
+    isValid &= compareEncoders("LocalPath", path, [&pathData](char *out){ return encodeLocalPath(10, pathData, out); }, LOCAL_PATH_OVERHEAD + pathData.size());
+    std::string entityData;
+    beginEntityStates(entityData, 1.5f);
+    for (uint32_t i = 0; i < 100; i++) {
+        appendEntityState(entityData, 100 + i, 0.01f * static_cast<float>(i), -0.02f * static_cast<float>(i));
+    }
+    uint32_t const nEntities = endEntityStates(entityData);
+    opendlv::sim::EntityStates entities;
+    entities.count(nEntities).data(entityData);
+    isValid &= compareEncoders("EntityStates", entities, [&](char *out){ return encodeEntityStates(nEntities, entityData, out); }, ENTITY_STATES_OVERHEAD + entityData.size());
+
+    // A later version that appends two bytes to every entity must still decode.
+    std::string appended{entityData.substr(0, ENTITY_STATES_HEADER_SIZE)};
+    appended[0] = static_cast<char>(ENTITY_STATES_VERSION + 1);
+    appended[1] = static_cast<char>(ENTITY_STATE_SIZE + 2);
+    for (uint32_t i = 0; i < nEntities; i++) {
+        appended.append(entityData, ENTITY_STATES_HEADER_SIZE + i * ENTITY_STATE_SIZE, ENTITY_STATE_SIZE).append(2, '\x7f');
+    }
+    float z{0.0f};
+    float appendedZ{0.0f};
+    std::vector<EntityState> decoded;
+    std::vector<EntityState> appendedDecoded;
+    bool const isAppendedDecoded = unpackEntityStates(entityData, z, decoded) && unpackEntityStates(appended, appendedZ, appendedDecoded)
+        && std::fabs(z - appendedZ) <= 0.0f && decoded.size() == nEntities && appendedDecoded.size() == nEntities
+        && std::equal(decoded.begin(), decoded.end(), appendedDecoded.begin(), [](const EntityState &a, const EntityState &b){
+               return a.senderStamp == b.senderStamp && std::fabs(a.x - b.x) <= 0.0f && std::fabs(a.y - b.y) <= 0.0f;
+           });
+    std::cout << std::setw(18) << "EntityStates v" + std::to_string(ENTITY_STATES_VERSION + 1) << std::setw(60) << (isAppendedDecoded ? "decoded" : "NOT DECODED") << std::endl;
+    isValid &= isAppendedDecoded;
+    return isValid;
+}
+
+// Envelope of a message as a controller would send it, for Episode::receive().
+template <typename T>
+cluon::data::Envelope envelopeOf(T &message, uint32_t senderStamp) {
+    cluon::ToProtoVisitor protoEncoder;
+    message.accept(protoEncoder);
+    cluon::data::Envelope envelope;
+    envelope.dataType(static_cast<int32_t>(message.ID()));
+    envelope.serializedData(protoEncoder.encodedData());
+    envelope.sampleTimeStamp(cluon::time::now());
+    envelope.senderStamp(senderStamp);
+    return envelope;
+}
+
+// Ticks of an offline episode (BatchPublisher not sending) whose drone visits
+// every waypoint of the scenario and completes the task halfway; returns the
+// heap allocations per tick of a second cycle, counted around Episode::tick()
+// only, and sets bytesPerTick to the published bytes of that cycle.
+double publishingAllocations(const Scenario &scenario, const EpisodeOptions &options, double &bytesPerTick) {
+    Episode episode{0, scenario, options, [](Episode &){}};
+    std::size_t bytes{0};
+    episode.addOutputSink([&bytes](const char *, std::size_t size){ bytes += size; });
+    opendlv::logic::action::PreviewPoint previewPoint;
+    previewPoint.distance(scenario.ballHoldDistance + 1.0f);
+    episode.receive(envelopeOf(previewPoint, 1));
+
+    constexpr uint32_t TICKS_PER_CYCLE{64};
+    uint64_t allocations{0};
+    for (uint32_t cycle = 0; cycle < 2; cycle++) {
+        for (uint32_t t = 0; t < TICKS_PER_CYCLE; t++) {
+            Waypoint const &position = scenario.waypoints.empty() ? scenario.hidden : scenario.waypoints[t % scenario.waypoints.size()];
+            opendlv::sim::Frame frame;
+            frame.x(position.x).y(position.y).z(scenario.height);
+            episode.receive(envelopeOf(frame, options.droneStamps.front()));
+            if ( t == TICKS_PER_CYCLE / 2 || t == TICKS_PER_CYCLE / 2 + 1 ){
+                opendlv::logic::sensation::CompleteFlag completeFlag;
+                completeFlag.task_completed(t == TICKS_PER_CYCLE / 2 ? 1 : 0);
+                episode.receive(envelopeOf(completeFlag, 0));
+            }
+
+            uint64_t const before = heapAllocations();
+            episode.tick();
+            allocations += (cycle == 0) ? 0 : heapAllocations() - before;
+        }
+        bytesPerTick = static_cast<double>(bytes) / TICKS_PER_CYCLE;
+        bytes = 0;
+    }
+    return static_cast<double>(allocations) / TICKS_PER_CYCLE;
+}
+
+// Publishes the built-in scenarios through Episode::tick() in every output mode;
+// false if a steady-state tick allocates or publishes nothing (--check, run by ctest).
+bool checkPublishing() {
+    bool isValid{true};
+    std::cout << std::endl << "Steady-state ticks of an offline episode (bytes and heap allocations per tick)" << std::endl;
+    std::cout << std::setw(30) << "scenario" << std::setw(12) << "bytes" << std::setw(12) << "allocs" << std::endl;
+    struct Mode {
+        const char *name;
+        bool isBulk;
+        bool isSingleDatagram;
+    };
+    for (std::string const name : {"rooms", "maze", "maze-chpad"}) {
+        Scenario scenario;
+        std::string error;
+        if ( !builtinScenario(name, scenario, error) ){
+            std::cout << std::setw(30) << name << " " << error << std::endl;
+            isValid = false;
+            continue;
+        }
+        for (Mode const mode : {Mode{"frames", false, false}, Mode{"bulk", true, false}, Mode{"single datagram", false, true}}) {
+            EpisodeOptions options;
+            options.isOffline = true;
+            options.lookAhead = 10;
+            options.isBulk = mode.isBulk;
+            options.isSingleDatagram = mode.isSingleDatagram;
+            double bytesPerTick{0.0};
+            double const allocations = publishingAllocations(scenario, options, bytesPerTick);
+            std::cout << std::setw(30) << (name + ", " + mode.name) << std::fixed << std::setprecision(1)
+                      << std::setw(12) << bytesPerTick << std::setprecision(3) << std::setw(12) << allocations << std::endl;
+            isValid &= (bytesPerTick > 0.0 && allocations <= 0.0);
+        }
+    }
+    return isValid;
+}
+
+// Median of the round trip times in microseconds.
+double median(std::vector<double> &samples) {
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+// Ping-pong of one envelope through two shared memory rings and an echo thread.
+double shmRoundTrip(const std::string &envelope, uint32_t rounds) {
+    ShmRing ping{"ball-sim-bench-ping", 1 << 16};
+    ShmRing pong{"ball-sim-bench-pong", 1 << 16};
+    if ( !ping.isValid() || !pong.isValid() ){
+        return -1.0;
+    }
+    std::atomic<bool> isRunning{true};
+    std::thread echo([&](){
+        while (isRunning.load()) {
+            ping.waitForData(std::chrono::milliseconds(10));
+            ping.drain([&](const char *data, std::size_t size){ pong.push(data, size); });
+        }
+    });
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < rounds; i++) {
+        auto const start = std::chrono::steady_clock::now();
+        ping.push(envelope.data(), envelope.size());
+        while (0 == pong.drain([](const char *, std::size_t){})) {
+            pong.waitForData(std::chrono::milliseconds(10));
+        }
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    isRunning.store(false);
+    echo.join();
+    return median(samples);
+}
+
+// Same ping-pong over UDP on the loopback interface; -1 if a socket call
+// failed or a datagram did not come back within a second.
+double udpRoundTrip(const std::string &envelope, uint32_t rounds) {
+    int const a = ::socket(AF_INET, SOCK_DGRAM, 0);
+    int const b = ::socket(AF_INET, SOCK_DGRAM, 0);
+    auto fail = [a, b](const char *what){
+        std::cerr << "UDP round trip: " << what << " failed: " << std::strerror(errno) << std::endl;
+        for (int const fd : {a, b}) {
+            if ( !(fd < 0) ){
+                ::close(fd);
+            }
+        }
+        return -1.0;
+    };
+    if ( a < 0 || b < 0 ){
+        return fail("socket");
+    }
+    struct timeval timeout{};
+    timeout.tv_sec = 1;
+    struct sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    struct sockaddr_in addressA = address;
+    struct sockaddr_in addressB = address;
+    socklen_t lengthA = sizeof(addressA);
+    socklen_t lengthB = sizeof(addressB);
+    if ( 0 != ::setsockopt(a, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout))
+         || 0 != ::setsockopt(b, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) ){
+        return fail("setsockopt");
+    }
+    if ( 0 != ::bind(a, reinterpret_cast<struct sockaddr *>(&addressA), sizeof(addressA))
+         || 0 != ::bind(b, reinterpret_cast<struct sockaddr *>(&addressB), sizeof(addressB)) ){
+        return fail("bind");
+    }
+    if ( 0 != ::getsockname(a, reinterpret_cast<struct sockaddr *>(&addressA), &lengthA)
+         || 0 != ::getsockname(b, reinterpret_cast<struct sockaddr *>(&addressB), &lengthB) ){
+        return fail("getsockname");
+    }
+
+    // The echo thread gives up once the measuring side did; a timeout only re-checks that.
+    std::atomic<bool> isRunning{true};
+    std::thread echo([&](){
+        char buffer[65536];
+        uint32_t nEchoed{0};
+        while (nEchoed < rounds && isRunning.load()) {
+            ssize_t const size = ::recv(b, buffer, sizeof(buffer), 0);
+            if ( size < 0 ){
+                continue;
+            }
+            if ( ::sendto(b, buffer, static_cast<std::size_t>(size), 0, reinterpret_cast<struct sockaddr *>(&addressA), sizeof(addressA)) < 0 ){
+                break;
+            }
+            nEchoed += 1;
+        }
+    });
+    std::vector<double> samples;
+    char buffer[65536];
+    const char *failed{nullptr};
+    for (uint32_t i = 0; i < rounds && nullptr == failed; i++) {
+        auto const start = std::chrono::steady_clock::now();
+        if ( ::sendto(a, envelope.data(), envelope.size(), 0, reinterpret_cast<struct sockaddr *>(&addressB), sizeof(addressB)) < 0 ){
+            failed = "sendto";
+        }
+        else if ( ::recv(a, buffer, sizeof(buffer), 0) < 0 ){
+            failed = "recv";
+        }
+        else{
+            samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+    int const error{errno};
+    isRunning.store(false);
+    echo.join();
+    if ( nullptr != failed ){
+        errno = error;
+        return fail(failed);
+    }
+    ::close(a);
+    ::close(b);
+    return median(samples);
+}
+
+// Ping-pong of a Frame between two OD4Sessions over multicast, as a controller sees the simulator.
+double od4RoundTrip(uint32_t rounds) {
+    cluon::OD4Session ping{OD4_BENCH_CID};
+    cluon::OD4Session pong{OD4_BENCH_CID};
+    std::mutex mutex;
+    std::condition_variable received;
+    uint32_t nReceived{0};
+    pong.dataTrigger(opendlv::sim::Frame::ID(), [&pong](cluon::data::Envelope &&envelope){
+        if ( 0 == envelope.senderStamp() ){
+            auto frame = cluon::extractMessage<opendlv::sim::Frame>(std::move(envelope));
+            pong.send(frame, cluon::time::now(), 1);
+        }
+    });
+    ping.dataTrigger(opendlv::sim::Frame::ID(), [&](cluon::data::Envelope &&envelope){
+        if ( 1 == envelope.senderStamp() ){
+            std::lock_guard<std::mutex> lck(mutex);
+            nReceived += 1;
+            received.notify_one();
+        }
+    });
+    if ( !ping.isRunning() || !pong.isRunning() ){
+        return -1.0;
+    }
+
+    opendlv::sim::Frame frame;
+    frame.x(1.25f).y(-0.7f).z(1.5f);
+    std::vector<double> samples;
+    for (uint32_t i = 0; i < rounds; i++) {
+        auto const start = std::chrono::steady_clock::now();
+        ping.send(frame, cluon::time::now(), 0);
+        std::unique_lock<std::mutex> lck(mutex);
+        if ( !received.wait_for(lck, std::chrono::seconds(1), [&](){ return nReceived > i; }) ){
+            return -1.0;
+        }
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    return median(samples);
+}
+
+// Targets with three waypoints each, sweeping visible balls and a charging pad,
+// spread at four targets per square metre like the capture benchmark.
+Scenario syntheticScenario(uint32_t nTargets, uint32_t nBalls, std::mt19937 &rng) {
+    float const side = std::sqrt(static_cast<float>(nTargets) / 4.0f);
+    std::uniform_real_distribution<float> coordinate{0.0f, side};
+    std::uniform_real_distribution<float> angle{0.0f, 6.2831853f};
+    Scenario scenario;
+    scenario.name = "synthetic";
+    scenario.ballAlertRadius = 0.1f;
+    scenario.hasChpad = true;
+    scenario.chpad = Waypoint{side / 2.0f, side / 2.0f};
+    for (uint32_t i = 0; i < nTargets; i++) {
+        uint32_t const first = static_cast<uint32_t>(scenario.waypoints.size());
+        for (uint32_t w = 0; w < 3; w++) {
+            scenario.waypoints.push_back(Waypoint{coordinate(rng), coordinate(rng)});
+        }
+        scenario.targets.push_back(TargetSpec{100 + i, first, first + 3});
+    }
+    for (uint32_t i = 0; i < nBalls; i++) {
+        float const a = angle(rng);
+        uint32_t const phase = static_cast<uint32_t>(scenario.phases.size());
+        scenario.phases.push_back(BallPhase{0.0f, coordinate(rng), coordinate(rng), std::cos(a), std::sin(a), true});
+        scenario.balls.push_back(BallSpec{100 + nTargets + i, -0.5f, 0.5f, 1.0f, 0.0f, 0.0f, phase, phase + 1});
+    }
+    return scenario;
+}
+
+// Drones at random positions over [lo, hi)^2 that restart the episode every 256 ticks.
+std::vector<Inputs> randomInputs(uint32_t nDrones, float lo, float hi, std::mt19937 &rng) {
+    std::uniform_real_distribution<float> coordinate{lo, hi};
+    std::vector<Inputs> inputs(256);
+    for (auto &input : inputs) {
+        for (uint32_t drone = 0; drone < nDrones; drone++) {
+            input.drones.push_back(DroneInput{coordinate(rng), coordinate(rng)});
+        }
+        input.previewDistance = 1.0f;
+    }
+    inputs.back().isTaskCompleted = true;
+    return inputs;
+}
+
+// Prints one row of the step table.
+void measureStep(const std::string &name, const std::string &label, World &world, const std::vector<Inputs> &inputs) {
+    std::size_t i{0};
+    auto tick = [&](){ step(world, inputs[i++ & 255], 0.1f); };
+    double const time = measure(name, tick);
+    double const allocations = allocationsPerRun(name, tick);
+    std::cout << std::setw(30) << label << std::fixed << std::setprecision(1)
+              << std::setw(14) << time << std::setw(12) << allocations << std::endl;
+}
+} // namespace
+
+int32_t main(int32_t argc, char **argv) {
+    auto commandlineArguments = cluon::getCommandlineArguments(argc, argv);
+    if ( 0 != commandlineArguments.count("check") ){
+        // --check runs both checks, --check=encoder or --check=publishing one of them.
+        std::string const check{commandlineArguments["check"]};
+        bool const isEncoderValid{("publishing" == check) || checkEncoders()};
+        bool const isPublishingValid{("encoder" == check) || checkPublishing()};
+        return (isEncoderValid && isPublishingValid) ? 0 : 1;
+    }
+    float const captureRadius{0.3f};
+    std::mt19937 rng{42};
+
+    std::cout << "Capture check per tick vs. number of targets (ns per tick)" << std::endl;
+    std::cout << std::setw(10) << "targets" << std::setw(14) << "linear" << std::setw(14) << "grid" << std::setw(14) << "grid move" << std::endl;
+    for (uint32_t n : {10u, 100u, 1000u, 10000u, 100000u}) {
+        // Constant density of four targets per square metre.
+        float const side = std::sqrt(static_cast<float>(n) / 4.0f);
+        std::uniform_real_distribution<float> coordinate{0.0f, side};
+        std::vector<Waypoint> positions(n);
+        for (auto &p : positions) {
+            p = Waypoint{coordinate(rng), coordinate(rng)};
+        }
+        std::vector<uint32_t> ids(n);
+        for (uint32_t i = 0; i < n; i++) {
+            ids[i] = i;
+        }
+        std::vector<Waypoint> queries(1024);
+        for (auto &q : queries) {
+            q = Waypoint{coordinate(rng), coordinate(rng)};
+        }
+
+        std::size_t q{0};
+        uint32_t found{0};
+        std::string const suffix{"/targets:" + std::to_string(n)};
+        double const linear = measure("capture/linear" + suffix, [&](){
+            Waypoint const &uav = queries[q++ & 1023];
+            for (uint32_t i = 0; i < n; i++) {
+                float const dist = std::sqrt(std::pow(uav.x - positions[i].x, 2.0f) + std::pow(uav.y - positions[i].y, 2.0f));
+                found += (dist <= captureRadius) ? 1 : 0;
+            }
+        });
+
+        TargetGrid grid{captureRadius};
+        grid.build(positions, ids);
+        for (uint32_t i = 0; i < n; i++) {
+            grid.setActive(i, true);
+        }
+        std::vector<uint32_t> result;
+        double const indexed = measure("capture/grid" + suffix, [&](){
+            Waypoint const &uav = queries[q++ & 1023];
+            result.clear();
+            grid.query(uav.x, uav.y, captureRadius, result);
+            found += static_cast<uint32_t>(result.size());
+        });
+        // What a capture costs the index: one entry off, another one on.
+        double const move = measure("capture/grid_move" + suffix, [&](){
+            uint32_t const entry = static_cast<uint32_t>(q++ % n);
+            grid.setActive(entry, false);
+            grid.setActive(entry, true);
+        });
+
+        std::cout << std::setw(10) << n << std::fixed << std::setprecision(1)
+                  << std::setw(14) << linear << std::setw(14) << indexed << std::setw(14) << move << std::endl;
+        if ( found == 0 ){
+            std::cout << " (no captures)" << std::endl;
+        }
+    }
+
+    std::cout << std::endl << "Proximity check of all entities per tick (ns per tick, kernel: " << distanceKernelName() << ")" << std::endl;
+    std::cout << std::setw(10) << "entities" << std::setw(14) << "pow/sqrt" << std::setw(14) << "kernel" << std::endl;
+    for (uint32_t n : {4u, 16u, 64u, 256u, 1024u, 4096u}) {
+        std::uniform_real_distribution<float> coordinate{-2.0f, 2.0f};
+        std::uniform_real_distribution<float> radius{0.05f, 0.3f};
+        EntityStore entities;
+        for (uint32_t i = 0; i < n; i++) {
+            entities.add(coordinate(rng), coordinate(rng), radius(rng));
+        }
+        std::vector<float> radii(n);
+        for (uint32_t i = 0; i < n; i++) {
+            radii[i] = std::sqrt(entities.radii2[i]);
+        }
+        std::vector<Waypoint> queries(1024);
+        for (auto &q : queries) {
+            q = Waypoint{coordinate(rng), coordinate(rng)};
+        }
+
+        std::size_t q{0};
+        uint32_t found{0};
+        std::string const suffix{"/entities:" + std::to_string(n)};
+        double const scalar = measure("proximity/pow_sqrt" + suffix, [&](){
+            Waypoint const &uav = queries[q++ & 1023];
+            for (uint32_t i = 0; i < n; i++) {
+                float const dist = std::sqrt(std::pow(uav.x - entities.xs[i], 2.0f) + std::pow(uav.y - entities.ys[i], 2.0f));
+                found += (dist <= radii[i]) ? 1 : 0;
+            }
+        });
+        std::vector<uint32_t> hits(n);
+        double const kernel = measure("proximity/kernel" + suffix, [&](){
+            Waypoint const &uav = queries[q++ & 1023];
+            found += withinRadii(uav.x, uav.y, entities.xs.data(), entities.ys.data(), entities.radii2.data(), n, hits.data());
+        });
+
+        std::cout << std::setw(10) << n << std::fixed << std::setprecision(1)
+                  << std::setw(14) << scalar << std::setw(14) << kernel << std::endl;
+        if ( found == 0 ){
+            std::cout << " (no hits)" << std::endl;
+        }
+    }
+
+    std::cout << std::endl << "World step per tick with drones at random positions (ns and heap allocations per tick)" << std::endl;
+    std::cout << std::setw(30) << "scenario" << std::setw(14) << "step" << std::setw(12) << "allocs" << std::endl;
+    for (std::string const name : {"rooms", "maze", "maze-chpad"}) {
+        Scenario scenario;
+        std::string error;
+        if ( !builtinScenario(name, scenario, error) ){
+            std::cout << std::setw(30) << name << " " << error << std::endl;
+            continue;
+        }
+        for (uint32_t nDrones : {1u, 8u}) {
+            World world{scenario, nDrones};
+            std::string const label{name + ", " + std::to_string(nDrones) + " drone(s)"};
+            measureStep("step/" + name + "/drones:" + std::to_string(nDrones), label, world, randomInputs(nDrones, -2.0f, 2.0f, rng));
+        }
+    }
+    struct Size {
+        uint32_t nTargets;
+        uint32_t nBalls;
+        uint32_t nDrones;
+    };
+    for (Size const size : {Size{10, 4, 1}, Size{100, 4, 1}, Size{1000, 4, 1}, Size{10000, 4, 1},
+                            Size{100, 16, 1}, Size{100, 256, 1}, Size{100, 4, 8}, Size{100, 4, 64}}) {
+        Scenario const scenario = syntheticScenario(size.nTargets, size.nBalls, rng);
+        World world{scenario, size.nDrones};
+        float const side = std::sqrt(static_cast<float>(size.nTargets) / 4.0f);
+        std::string const label{std::to_string(size.nTargets) + "t " + std::to_string(size.nBalls) + "b " + std::to_string(size.nDrones) + "d"};
+        std::string const name{"step/synthetic/targets:" + std::to_string(size.nTargets)
+            + "/balls:" + std::to_string(size.nBalls) + "/drones:" + std::to_string(size.nDrones)};
+        measureStep(name, label, world, randomInputs(size.nDrones, 0.0f, side, rng));
+    }
+
+    std::cout << std::endl << "Ball look-ahead of 16 balls, extended per tick vs. predicted from scratch (ns per tick)" << std::endl;
+    std::cout << std::setw(10) << "poses" << std::setw(14) << "incremental" << std::setw(14) << "scratch" << std::endl;
+    Scenario const lookAheadScenario = syntheticScenario(100, 16, rng);
+    std::vector<Inputs> const lookAheadInputs = randomInputs(1, 0.0f, 5.0f, rng);
+    for (uint32_t n : {10u, 100u}) {
+        World world{lookAheadScenario, 1, n};
+        std::size_t i{0};
+        std::string const name{"step/lookahead/poses:" + std::to_string(n)};
+        double const incremental = measure(name + "/incremental", [&](){ step(world, lookAheadInputs[i++ & 255], 0.1f); });
+        double const scratch = measure(name + "/scratch", [&](){
+            world.isLookAheadValid = false;
+            step(world, lookAheadInputs[i++ & 255], 0.1f);
+        });
+        std::cout << std::setw(10) << n << std::fixed << std::setprecision(1)
+                  << std::setw(14) << incremental << std::setw(14) << scratch << std::endl;
+    }
+
+    bool const isEncoderValid{checkEncoders()};
+    bool const isPublishingValid{checkPublishing()};
+    opendlv::sim::Frame frame;
+    frame.x(1.25f).y(-0.7f).z(1.5f);
+
+    std::cout << std::endl << "Scene of N entities per tick, one Frame each vs. one packed EntityStates (bytes, ns to encode and to decode all)" << std::endl;
+    std::cout << std::setw(10) << "entities" << std::setw(12) << "bytes" << std::setw(12) << "packed"
+              << std::setw(12) << "encode" << std::setw(12) << "packed" << std::setw(12) << "decode" << std::setw(12) << "packed" << std::endl;
+    bool isSceneValid{true};
+    for (uint32_t n : {10u, 100u, 1000u}) {
+        cluon::data::TimeStamp const sent = cluon::time::now();
+        std::vector<EntityState> scene;
+        for (uint32_t i = 0; i < n; i++) {
+            scene.push_back(EntityState{100 + i, std::uniform_real_distribution<float>(-10.0f, 10.0f)(rng), std::uniform_real_distribution<float>(-10.0f, 10.0f)(rng)});
+        }
+        std::vector<char> frames;
+        std::vector<char> packed;
+        std::vector<char> payload(ENTITY_STATES_OVERHEAD + ENTITY_STATES_HEADER_SIZE + n * ENTITY_STATE_SIZE);
+        std::string data;
+        auto encodeFrames = [&](){
+            frames.clear();
+            opendlv::sim::Frame entityFrame;
+            entityFrame.z(1.5f);
+            for (EntityState const &entity : scene) {
+                entityFrame.x(entity.x).y(entity.y);
+                std::size_t const payloadSize = encodePayload(entityFrame, payload.data());
+                appendEnvelope(frames, static_cast<int32_t>(opendlv::sim::Frame::ID()), payload.data(), payloadSize, sent, sent, entity.senderStamp);
+            }
+        };
+        auto encodePacked = [&](){
+            packed.clear();
+            beginEntityStates(data, 1.5f);
+            for (EntityState const &entity : scene) {
+                appendEntityState(data, entity.senderStamp, entity.x, entity.y);
+            }
+            std::size_t const payloadSize = encodeEntityStates(endEntityStates(data), data, payload.data());
+            appendEnvelope(packed, static_cast<int32_t>(opendlv::sim::EntityStates::ID()), payload.data(), payloadSize, sent, sent, 0);
+        };
+        std::string const name{"scene/entities:" + std::to_string(n)};
+        double const framesEncode = measure(name + "/frames/encode", encodeFrames);
+        double const packedEncode = measure(name + "/packed/encode", encodePacked);
+
+        // Decoded as a subscriber would: every envelope into its message.
+        std::string const framesWire(frames.begin(), frames.end());
+        std::string const packedWire(packed.begin(), packed.end());
+        uint64_t decodedEntities{0};
+        auto decodeFrames = [&](){
+            std::stringstream sstr{framesWire};
+            for (uint32_t i = 0; i < n; i++) {
+                auto envelope = cluon::extractEnvelope(sstr);
+                decodedEntities += (cluon::extractMessage<opendlv::sim::Frame>(std::move(envelope.second)).z() > 0.0f) ? 1 : 0;
+            }
+        };
+        std::vector<EntityState> decoded;
+        auto decodePacked = [&](){
+            std::stringstream sstr{packedWire};
+            auto envelope = cluon::extractEnvelope(sstr);
+            float z;
+            unpackEntityStates(cluon::extractMessage<opendlv::sim::EntityStates>(std::move(envelope.second)).data(), z, decoded);
+            decodedEntities += decoded.size();
+        };
+        double const framesDecode = measure(name + "/frames/decode", decodeFrames);
+        double const packedDecode = measure(name + "/packed/decode", decodePacked);
+
+        // The packed positions are within half a quantum of the frames'.
+        float maxError{0.0f};
+        for (std::size_t i = 0; i < decoded.size() && decoded.size() == scene.size(); i++) {
+            maxError = std::max(maxError, std::max(std::fabs(decoded[i].x - scene[i].x), std::fabs(decoded[i].y - scene[i].y)));
+        }
+        bool const isSceneMatching{decoded.size() == scene.size() && maxError <= 0.5f * ENTITY_STATES_QUANTUM * 1.001f};
+        isSceneValid &= isSceneMatching;
+        std::cout << std::setw(10) << n << std::setw(12) << frames.size() << std::setw(12) << packed.size()
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(12) << framesEncode << std::setw(12) << packedEncode
+                  << std::setw(12) << framesDecode << std::setw(12) << packedDecode
+                  << (isSceneMatching ? "" : "  MISMATCH") << std::endl;
+    }
+
+    std::string const envelope = encodeWithCluon(frame, cluon::time::now(), 0);
+    std::cout << std::endl << "Frame decoding as in onFrame (ns and heap allocations per message)" << std::endl;
+    std::cout << std::setw(18) << "step" << std::setw(12) << "time" << std::setw(12) << "allocs" << std::endl;
+    uint64_t decoded{0};
+    auto extractEnvelope = [&](){
+        std::stringstream sstr{envelope};
+        decoded += cluon::extractEnvelope(sstr).first ? 1 : 0;
+    };
+    std::stringstream sstr{envelope};
+    cluon::data::Envelope const frameEnvelope = cluon::extractEnvelope(sstr).second;
+    auto extractMessage = [&](){
+        cluon::data::Envelope copy{frameEnvelope};
+        decoded += (cluon::extractMessage<opendlv::sim::Frame>(std::move(copy)).x() > 0.0f) ? 1 : 0;
+    };
+    // What the episode does with a frame of an untracked drone.
+    EnvelopeFilter filter;
+    filter.accept(opendlv::sim::Frame::ID(), 4);
+    auto peekAndReject = [&](){
+        EnvelopeHeader header;
+        decoded += (peekEnvelope(envelope.data(), envelope.size(), header) && !filter.isAccepted(header.dataType, header.senderStamp)) ? 1 : 0;
+    };
+    for (auto const &decoder : {std::make_pair(std::string("extractEnvelope"), std::function<void()>(extractEnvelope)),
+                                std::make_pair(std::string("extractMessage"), std::function<void()>(extractMessage)),
+                                std::make_pair(std::string("peek and reject"), std::function<void()>(peekAndReject))}) {
+        std::string const name{"decode/" + decoder.first + "/Frame"};
+        double const time = measure(name, decoder.second);
+        double const allocations = allocationsPerRun(name, decoder.second);
+        std::cout << std::setw(18) << decoder.first << std::fixed << std::setprecision(1)
+                  << std::setw(12) << time << std::setw(12) << allocations << std::endl;
+    }
+    if ( decoded == 0 ){
+        std::cout << " (nothing decoded)" << std::endl;
+    }
+    std::string const stamped = encodeWithCluon(frame, cluon::time::now(), 7) + envelope;
+    EnvelopeHeader header;
+    bool const isPeekValid{peekEnvelope(stamped.data(), stamped.size(), header) && header.dataType == opendlv::sim::Frame::ID()
+                           && header.senderStamp == 7 && header.size == stamped.size() - envelope.size()};
+    if ( !isPeekValid ){
+        std::cout << " (peekEnvelope disagrees with cluon)" << std::endl;
+    }
+
+    uint32_t const rounds{20000};
+    double const udp = udpRoundTrip(envelope, rounds);
+    double const shm = shmRoundTrip(envelope, rounds);
+    double const od4 = od4RoundTrip(rounds / 10);
+    addLatency("roundtrip/udp_loopback/Frame", rounds, udp);
+    addLatency("roundtrip/shared_memory/Frame", rounds, shm);
+    addLatency("roundtrip/od4session/Frame", rounds / 10, od4);
+    std::cout << std::endl << "Frame envelope ping-pong between two threads (median round trip in us)" << std::endl;
+    std::cout << std::setw(18) << "udp loopback" << std::setw(18) << "shared memory" << std::setw(18) << "OD4Session" << std::endl;
+    std::cout << std::fixed << std::setprecision(2) << std::setw(18) << udp << std::setw(18) << shm << std::setw(18) << od4 << std::endl;
+
+    if ( 0 != commandlineArguments.count("json") ){
+        if ( !writeJson(commandlineArguments["json"], argv[0]) ){
+            std::cerr << "Could not write " << commandlineArguments["json"] << "..." << std::endl;
+            return 1;
+        }
+        std::cout << std::endl << "Wrote " << results().size() << " results to " << commandlineArguments["json"] << std::endl;
+    }
+    if ( !isEncoderValid ){
+        std::cerr << "The encoder differs from cluon or allocates..." << std::endl;
+        return 1;
+    }
+    if ( !isPublishingValid ){
+        std::cerr << "Publishing a tick allocates..." << std::endl;
+        return 1;
+    }
+    if ( !isSceneValid ){
+        std::cerr << "The packed scene differs from the one Frame per entity..." << std::endl;
+        return 1;
+    }
+    if ( !isPeekValid ){
+        std::cerr << "peekEnvelope differs from cluon..." << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batch-publisher.hpp"
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace {
+// Largest UDP payload over IPv4.
+constexpr std::size_t MAX_DATAGRAM_SIZE{65507};
+// Upper bound of messages per sendmmsg call (UIO_MAXIOV).
+constexpr std::size_t MAX_MESSAGES_PER_CALL{1024};
+
+std::size_t datagramSizeOf(const struct mmsghdr &message) noexcept
+{
+    std::size_t size{0};
+    for (std::size_t i = 0; i < message.msg_hdr.msg_iovlen; i++) {
+        size += message.msg_hdr.msg_iov[i].iov_len;
+    }
+    return size;
+}
+}
+
+BatchPublisher::BatchPublisher(uint16_t cid, bool isSingleDatagram, bool isSending) noexcept
+    : m_isSingleDatagram{isSingleDatagram}
+{
+    if ( !isSending ){
+        return;
+    }
+    std::string const address{"225.0.0." + std::to_string(cid)};
+    m_sendToAddress.sin_family = AF_INET;
+    m_sendToAddress.sin_addr.s_addr = ::inet_addr(address.c_str());
+    m_sendToAddress.sin_port = htons(12175);
+
+    m_socket = ::socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if ( m_socket < 0 ){
+        std::cerr << "[BatchPublisher] Error while creating socket: " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    // Bind to a random port and remember it, like cluon::UDPSender.
+    struct sockaddr_in sendFromAddress;
+    std::memset(&sendFromAddress, 0, sizeof(sendFromAddress));
+    sendFromAddress.sin_family = AF_INET;
+    socklen_t length = sizeof(sendFromAddress);
+    if ( 0 == ::bind(m_socket, reinterpret_cast<struct sockaddr *>(&sendFromAddress), sizeof(sendFromAddress))
+        && 0 == ::getsockname(m_socket, reinterpret_cast<struct sockaddr *>(&sendFromAddress), &length) ){
+        m_sendFromPort = ntohs(sendFromAddress.sin_port);
+    }
+}
+
+BatchPublisher::~BatchPublisher() noexcept
+{
+    if ( !(m_socket < 0) ){
+        ::close(m_socket);
+    }
+}
+
+void BatchPublisher::add(opendlv::sim::Frame &frame, const cluon::data::TimeStamp &sampleTimeStamp, uint32_t senderStamp) noexcept
+{
+    char payload[MAX_FIXED_PAYLOAD_SIZE];
+    std::size_t const payloadSize = encodePayload(frame, payload);
+    append(static_cast<int32_t>(opendlv::sim::Frame::ID()), payload, payloadSize, sampleTimeStamp, senderStamp);
+}
+
+void BatchPublisher::add(opendlv::sim::KinematicState &state, const cluon::data::TimeStamp &sampleTimeStamp, uint32_t senderStamp) noexcept
+{
+    char payload[MAX_FIXED_PAYLOAD_SIZE];
+    std::size_t const payloadSize = encodePayload(state, payload);
+    append(static_cast<int32_t>(opendlv::sim::KinematicState::ID()), payload, payloadSize, sampleTimeStamp, senderStamp);
+}
+
+void BatchPublisher::add(opendlv::logic::sensation::TargetFoundState &state, const cluon::data::TimeStamp &sampleTimeStamp, uint32_t senderStamp) noexcept
+{
+    char payload[MAX_FIXED_PAYLOAD_SIZE];
+    std::size_t const payloadSize = encodePayload(state, payload);
+    append(static_cast<int32_t>(opendlv::logic::sensation::TargetFoundState::ID()), payload, payloadSize, sampleTimeStamp, senderStamp);
+}
+
+void BatchPublisher::addLocalPath(uint32_t length, const std::string &data, const cluon::data::TimeStamp &sampleTimeStamp, uint32_t senderStamp) noexcept
+{
+    if ( m_payload.size() < LOCAL_PATH_OVERHEAD + data.size() ){
+        m_payload.resize(LOCAL_PATH_OVERHEAD + data.size());
+    }
+    std::size_t const payloadSize = encodeLocalPath(length, data, m_payload.data());
+    append(static_cast<int32_t>(opendlv::logic::action::LocalPath::ID()), m_payload.data(), payloadSize, sampleTimeStamp, senderStamp);
+}
+
+void BatchPublisher::addEntityStates(uint32_t count, const std::string &data, const cluon::data::TimeStamp &sampleTimeStamp, uint32_t senderStamp) noexcept
+{
+    if ( m_payload.size() < ENTITY_STATES_OVERHEAD + data.size() ){
+        m_payload.resize(ENTITY_STATES_OVERHEAD + data.size());
+    }
+    std::size_t const payloadSize = encodeEntityStates(count, data, m_payload.data());
+    append(static_cast<int32_t>(opendlv::sim::EntityStates::ID()), m_payload.data(), payloadSize, sampleTimeStamp, senderStamp);
+}
+
+void BatchPublisher::append(int32_t dataType, const char *payload, std::size_t payloadSize, const cluon::data::TimeStamp &sampleTimeStamp, uint32_t senderStamp) noexcept
+{
+    if ( m_envelopeEnds.empty() ){
+        m_sent = cluon::time::now();
+    }
+    bool const isSampleTimeStampSet{0 != (sampleTimeStamp.seconds() + sampleTimeStamp.microseconds())};
+    appendEnvelope(m_buffer, dataType, payload, payloadSize, m_sent, isSampleTimeStampSet ? sampleTimeStamp : m_sent, senderStamp);
+    m_envelopeEnds.push_back(m_buffer.size());
+}
+
+std::size_t BatchPublisher::size() const noexcept
+{
+    return m_buffer.size();
+}
+
+void BatchPublisher::addSink(std::function<void(const char *, std::size_t)> sink) noexcept
+{
+    m_sinks.push_back(std::move(sink));
+}
+
+uint16_t BatchPublisher::sendFromPort() const noexcept
+{
+    return m_sendFromPort;
+}
+
+uint64_t BatchPublisher::sendErrors() const noexcept
+{
+    return m_sendErrors.load(std::memory_order_relaxed);
+}
+
+void BatchPublisher::encodingFailed(int32_t dataType, const std::exception &e) noexcept
+{
+    if ( !m_isEncodingErrorLogged ){
+        m_isEncodingErrorLogged = true;
+        std::cerr << "[BatchPublisher] Error while encoding a message of type " << dataType << ": " << e.what()
+                  << "; further encoding errors are only counted." << std::endl;
+    }
+    m_sendErrors.store(m_sendErrors.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void BatchPublisher::flush() noexcept
+{
+    if ( m_envelopeEnds.empty() ){
+        return;
+    }
+
+    // One iovec per envelope; consecutive iovecs form a datagram.
+    std::vector<struct iovec> &iovecs = m_iovecs;
+    std::vector<struct mmsghdr> &messages = m_messages;
+    iovecs.resize(m_envelopeEnds.size());
+    messages.clear();
+    std::size_t datagramSize{0};
+    for (std::size_t i = 0; i < m_envelopeEnds.size(); i++) {
+        std::size_t const begin{(0 == i) ? 0 : m_envelopeEnds[i - 1]};
+        iovecs[i].iov_base = m_buffer.data() + begin;
+        iovecs[i].iov_len = m_envelopeEnds[i] - begin;
+        for (auto &sink : m_sinks) {
+            sink(m_buffer.data() + begin, iovecs[i].iov_len);
+        }
+
+        bool const isAppended{m_isSingleDatagram && !messages.empty() && datagramSize + iovecs[i].iov_len <= MAX_DATAGRAM_SIZE};
+        if ( isAppended ){
+            messages.back().msg_hdr.msg_iovlen += 1;
+            datagramSize += iovecs[i].iov_len;
+        }
+        else{
+            struct mmsghdr message;
+            std::memset(&message, 0, sizeof(message));
+            message.msg_hdr.msg_name = &m_sendToAddress;
+            message.msg_hdr.msg_namelen = sizeof(m_sendToAddress);
+            message.msg_hdr.msg_iov = &iovecs[i];
+            message.msg_hdr.msg_iovlen = 1;
+            messages.push_back(message);
+            datagramSize = iovecs[i].iov_len;
+        }
+    }
+
+    // sendmmsg stops at the first failing message and reports it on the next call;
+    // that message is counted and skipped so the rest of the tick still goes out.
+    std::size_t sent{0};
+    while ( !(m_socket < 0) && sent < messages.size() ){
+        std::size_t const count{std::min(messages.size() - sent, MAX_MESSAGES_PER_CALL)};
+        int const retVal = ::sendmmsg(m_socket, &messages[sent], static_cast<unsigned int>(count), 0);
+        if ( retVal < 0 ){
+            if ( EINTR == errno ){
+                continue;
+            }
+            if ( m_lastErrno != errno ){
+                m_lastErrno = errno;
+                std::cerr << "[BatchPublisher] Error while sending a datagram of " << datagramSizeOf(messages[sent])
+                          << " bytes: " << std::strerror(errno) << std::endl;
+            }
+            m_sendErrors.store(m_sendErrors.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            sent += 1;
+            continue;
+        }
+        sent += static_cast<std::size_t>(retVal);
+    }
+    m_buffer.clear();
+    m_envelopeEnds.clear();
+}
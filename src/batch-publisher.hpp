@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCH_PUBLISHER_HPP
+#define BATCH_PUBLISHER_HPP
+
+#include "ball-simulator-messages.hpp"
+#include "cluon-complete.hpp"
+#include "envelope-encoder.hpp"
+#include "opendlv-standard-message-set.hpp"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Collects the envelopes of one tick and emits them to the OD4Session of
+ * the given CID in one system call (sendmmsg). By default every envelope
+ * stays its own datagram, so stock OD4Session subscribers see no difference.
+ * In single datagram mode the envelopes are concatenated instead; the tick
+ * then arrives atomically, but subscribers have to unpack every envelope of
+ * a datagram. Not thread-safe; every episode owns its publisher.
+ */
+class BatchPublisher {
+   private:
+    BatchPublisher(const BatchPublisher &) = delete;
+    BatchPublisher(BatchPublisher &&)      = delete;
+    BatchPublisher &operator=(const BatchPublisher &) = delete;
+    BatchPublisher &operator=(BatchPublisher &&) = delete;
+
+   public:
+    /**
+     * @param isSending Send to the network; otherwise envelopes only reach the sinks.
+     */
+    BatchPublisher(uint16_t cid, bool isSingleDatagram, bool isSending = true) noexcept;
+    ~BatchPublisher() noexcept;
+
+   public:
+    /**
+     * Encodes a message into the current batch, stamped like OD4Session::send.
+     * Messages without a dedicated encoder go through cluon::ToProtoVisitor;
+     * a message it fails to encode is dropped, logged and counted in sendErrors().
+     */
+    template <typename T>
+    void add(T &message, const cluon::data::TimeStamp &sampleTimeStamp = cluon::data::TimeStamp(), uint32_t senderStamp = 0) noexcept {
+        try {
+            cluon::ToProtoVisitor protoEncoder;
+            message.accept(protoEncoder);
+            std::string const payload{protoEncoder.encodedData()};
+            append(static_cast<int32_t>(message.ID()), payload.data(), payload.size(), sampleTimeStamp, senderStamp);
+        } catch (std::exception const &e) {
+            encodingFailed(static_cast<int32_t>(message.ID()), e);
+        }
+    }
+
+    void add(opendlv::sim::Frame &frame, const cluon::data::TimeStamp &sampleTimeStamp = cluon::data::TimeStamp(), uint32_t senderStamp = 0) noexcept;
+    void add(opendlv::sim::KinematicState &state, const cluon::data::TimeStamp &sampleTimeStamp = cluon::data::TimeStamp(), uint32_t senderStamp = 0) noexcept;
+    void add(opendlv::logic::sensation::TargetFoundState &state, const cluon::data::TimeStamp &sampleTimeStamp = cluon::data::TimeStamp(), uint32_t senderStamp = 0) noexcept;
+    void addLocalPath(uint32_t length, const std::string &data, const cluon::data::TimeStamp &sampleTimeStamp = cluon::data::TimeStamp(), uint32_t senderStamp = 0) noexcept;
+    void addEntityStates(uint32_t count, const std::string &data, const cluon::data::TimeStamp &sampleTimeStamp = cluon::data::TimeStamp(), uint32_t senderStamp = 0) noexcept;
+
+    /**
+     * @return Bytes of the envelopes added since the last flush.
+     */
+    std::size_t size() const noexcept;
+
+    /**
+     * Sends all envelopes added since the last flush.
+     */
+    void flush() noexcept;
+
+    /**
+     * Registers a consumer that gets a copy of every flushed envelope
+     * (shared memory ring, recorder); called on the flushing thread.
+     */
+    void addSink(std::function<void(const char *, std::size_t)> sink) noexcept;
+
+    /**
+     * @return Local port the datagrams are sent from, to filter them on receive.
+     */
+    uint16_t sendFromPort() const noexcept;
+
+    /**
+     * @return Datagrams that could not be sent, the rest of their flush went
+     *         out, plus messages that could not be encoded.
+     */
+    uint64_t sendErrors() const noexcept;
+
+   private:
+    void append(int32_t dataType, const char *payload, std::size_t payloadSize, const cluon::data::TimeStamp &sampleTimeStamp, uint32_t senderStamp) noexcept;
+    void encodingFailed(int32_t dataType, const std::exception &e) noexcept;
+
+   private:
+    int32_t m_socket{-1};
+    struct sockaddr_in m_sendToAddress{};
+    bool const m_isSingleDatagram;
+    uint16_t m_sendFromPort{0};
+    // Read by the metrics endpoint; the errno of the last failure is only logged once.
+    std::atomic<uint64_t> m_sendErrors{0};
+    int m_lastErrno{0};
+    bool m_isEncodingErrorLogged{false};
+    std::vector<std::function<void(const char *, std::size_t)>> m_sinks{};
+    cluon::data::TimeStamp m_sent{};
+    // Encoded envelopes of the current batch back to back, and where each one ends.
+    std::vector<char> m_buffer{};
+    std::vector<std::size_t> m_envelopeEnds{};
+    // Scratch space of flush(), kept to avoid allocations per tick.
+    std::vector<struct iovec> m_iovecs{};
+    std::vector<struct mmsghdr> m_messages{};
+    // Payload of the variable sized messages.
+    std::vector<char> m_payload{};
+};
+
+#endif
@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "batch-receiver.hpp"
+
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace {
+// Control message space per datagram for its SO_TIMESTAMP.
+constexpr std::size_t CONTROL_SIZE{CMSG_SPACE(sizeof(struct timeval))};
+// How often the receive thread checks for shutdown.
+constexpr int32_t POLL_TIMEOUT_MS{20};
+// Receive buffer to ask for, so that a tick's worth of high rate datagrams fits.
+constexpr int32_t RECEIVE_BUFFER_SIZE{4 << 20};
+}
+
+constexpr std::size_t BatchReceiver::MAX_BATCH;
+constexpr std::size_t BatchReceiver::MAX_DATAGRAM_SIZE;
+
+BatchReceiver::BatchReceiver(const std::string &group, uint16_t port, uint16_t sendFromPort,
+    std::function<void(const Datagram *, std::size_t)> delegate, bool isThreaded) noexcept
+    : m_sendFromPort{sendFromPort}
+    , m_delegate{std::move(delegate)}
+    , m_buffer{new char[MAX_BATCH * MAX_DATAGRAM_SIZE]}
+    , m_control(MAX_BATCH * CONTROL_SIZE)
+    , m_iovecs(MAX_BATCH)
+    , m_from(MAX_BATCH)
+    , m_messages(MAX_BATCH)
+    , m_datagrams(MAX_BATCH)
+    , m_isThreaded{isThreaded}
+{
+    m_socket = ::socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if ( m_socket < 0 ){
+        std::cerr << "[BatchReceiver] Error while creating socket: " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    // Like cluon::UDPReceiver: several processes share the group's port.
+    int32_t const YES{1};
+    struct sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = ::inet_addr(group.c_str());
+    address.sin_port = htons(port);
+    m_mreq.imr_multiaddr.s_addr = ::inet_addr(group.c_str());
+    m_mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    if ( 0 != ::setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &YES, sizeof(YES))
+        || 0 != ::setsockopt(m_socket, SOL_SOCKET, SO_TIMESTAMP, &YES, sizeof(YES))
+        || 0 != ::bind(m_socket, reinterpret_cast<struct sockaddr *>(&address), sizeof(address))
+        || 0 != ::setsockopt(m_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &m_mreq, sizeof(m_mreq)) ){
+        std::cerr << "[BatchReceiver] Could not join " << group << ":" << port << ": " << std::strerror(errno) << std::endl;
+        ::close(m_socket);
+        m_socket = -1;
+        return;
+    }
+    // Best effort; the kernel caps it at net.core.rmem_max.
+    ::setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &RECEIVE_BUFFER_SIZE, sizeof(RECEIVE_BUFFER_SIZE));
+
+    struct ifaddrs *interfaceAddresses;
+    if ( 0 == ::getifaddrs(&interfaceAddresses) ){
+        for (struct ifaddrs *it = interfaceAddresses; nullptr != it; it = it->ifa_next) {
+            if ( nullptr != it->ifa_addr && AF_INET == it->ifa_addr->sa_family ){
+                m_localAddresses.insert(reinterpret_cast<struct sockaddr_in *>(it->ifa_addr)->sin_addr.s_addr);
+            }
+        }
+        ::freeifaddrs(interfaceAddresses);
+    }
+
+    for (std::size_t i = 0; i < MAX_BATCH; i++) {
+        m_iovecs[i].iov_base = m_buffer.get() + i * MAX_DATAGRAM_SIZE;
+        m_iovecs[i].iov_len = MAX_DATAGRAM_SIZE;
+    }
+
+    m_isRunning.store(true);
+    if ( m_isThreaded ){
+        m_receiver = std::thread(&BatchReceiver::receive, this);
+    }
+}
+
+BatchReceiver::~BatchReceiver() noexcept
+{
+    m_isRunning.store(false);
+    if ( m_receiver.joinable() ){
+        m_receiver.join();
+    }
+    if ( !(m_socket < 0) ){
+        ::setsockopt(m_socket, IPPROTO_IP, IP_DROP_MEMBERSHIP, &m_mreq, sizeof(m_mreq));
+        ::close(m_socket);
+    }
+}
+
+bool BatchReceiver::isRunning() const noexcept
+{
+    return m_isRunning.load() && !cluon::TerminateHandler::instance().isTerminated.load();
+}
+
+uint64_t BatchReceiver::batches() const noexcept
+{
+    return m_batches.load(std::memory_order_relaxed);
+}
+
+uint64_t BatchReceiver::truncated() const noexcept
+{
+    return m_truncated.load(std::memory_order_relaxed);
+}
+
+void BatchReceiver::receive() noexcept
+{
+    struct pollfd fd{m_socket, POLLIN, 0};
+    while (m_isRunning.load()) {
+        if ( 0 < ::poll(&fd, 1, POLL_TIMEOUT_MS) ){
+            drain();
+        }
+    }
+}
+
+void BatchReceiver::drain() noexcept
+{
+    if ( m_socket < 0 ){
+        return;
+    }
+    // Everything that queued up, MAX_BATCH datagrams per call.
+    int32_t count{0};
+    do {
+        for (std::size_t i = 0; i < MAX_BATCH; i++) {
+            struct msghdr &header = m_messages[i].msg_hdr;
+            std::memset(&header, 0, sizeof(header));
+            header.msg_name = &m_from[i];
+            header.msg_namelen = sizeof(m_from[i]);
+            header.msg_iov = &m_iovecs[i];
+            header.msg_iovlen = 1;
+            header.msg_control = m_control.data() + i * CONTROL_SIZE;
+            header.msg_controllen = CONTROL_SIZE;
+        }
+        count = ::recvmmsg(m_socket, m_messages.data(), static_cast<unsigned int>(MAX_BATCH), MSG_DONTWAIT, nullptr);
+        if ( count <= 0 ){
+            break;
+        }
+
+        std::size_t nDatagrams{0};
+        for (int32_t i = 0; i < count; i++) {
+            struct msghdr &header = m_messages[i].msg_hdr;
+            bool const isFromUs = ntohs(m_from[i].sin_port) == m_sendFromPort
+                && m_localAddresses.end() != m_localAddresses.find(m_from[i].sin_addr.s_addr);
+            if ( 0 != (header.msg_flags & MSG_TRUNC) ){
+                m_truncated.store(m_truncated.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                continue;
+            }
+            if ( isFromUs ){
+                continue;
+            }
+
+            cluon::data::TimeStamp received{cluon::time::now()};
+            for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&header); nullptr != cmsg; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+                if ( SOL_SOCKET == cmsg->cmsg_level && SCM_TIMESTAMP == cmsg->cmsg_type ){
+                    struct timeval tv;
+                    std::memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+                    received.seconds(static_cast<int32_t>(tv.tv_sec)).microseconds(static_cast<int32_t>(tv.tv_usec));
+                }
+            }
+            m_datagrams[nDatagrams++] = Datagram{static_cast<const char *>(m_iovecs[i].iov_base), m_messages[i].msg_len, received};
+        }
+        m_batches.store(m_batches.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if ( 0 < nDatagrams ){
+            m_delegate(m_datagrams.data(), nDatagrams);
+        }
+    } while (static_cast<std::size_t>(count) == MAX_BATCH);
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BATCH_RECEIVER_HPP
+#define BATCH_RECEIVER_HPP
+
+#include "cluon-complete.hpp"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Receives the datagrams of an OD4 multicast group like cluon::UDPReceiver,
+ * but drains the socket with recvmmsg: every drain hands the queued datagrams
+ * to the delegate in batches of up to MAX_BATCH, with their kernel receive
+ * time. Datagrams sent from sendFromPort of a local address, i.e. by this
+ * process, are skipped. With a receive thread, the socket is drained whenever
+ * data arrives; without, the owner calls drain(), e.g. once per tick, and the
+ * datagrams in between queue up in the socket's receive buffer.
+ */
+class BatchReceiver {
+   private:
+    BatchReceiver(const BatchReceiver &) = delete;
+    BatchReceiver(BatchReceiver &&)      = delete;
+    BatchReceiver &operator=(const BatchReceiver &) = delete;
+    BatchReceiver &operator=(BatchReceiver &&) = delete;
+
+   public:
+    struct Datagram {
+        const char *data;
+        std::size_t size;
+        cluon::data::TimeStamp received;
+    };
+
+    // Datagrams per recvmmsg call and the bytes kept of each, the largest UDP
+    // payload over IPv4 like cluon::UDPReceiver; longer ones are dropped and counted.
+    static constexpr std::size_t MAX_BATCH{64};
+    static constexpr std::size_t MAX_DATAGRAM_SIZE{65507};
+
+   public:
+    BatchReceiver(const std::string &group, uint16_t port, uint16_t sendFromPort,
+        std::function<void(const Datagram *, std::size_t)> delegate, bool isThreaded = true) noexcept;
+    ~BatchReceiver() noexcept;
+
+   public:
+    /**
+     * Hands everything received so far to the delegate; only to be called
+     * without receive thread.
+     */
+    void drain() noexcept;
+
+    bool isRunning() const noexcept;
+    uint64_t batches() const noexcept;
+    uint64_t truncated() const noexcept;
+
+   private:
+    void receive() noexcept;
+
+   private:
+    int32_t m_socket{-1};
+    struct ip_mreq m_mreq{};
+    uint16_t const m_sendFromPort;
+    std::set<in_addr_t> m_localAddresses{};
+    std::function<void(const Datagram *, std::size_t)> m_delegate;
+
+    // recvmmsg buffers, only touched by the receive thread. The datagram slots are
+    // left uninitialized, so that only the pages the kernel writes to are backed.
+    std::unique_ptr<char[]> m_buffer;
+    std::vector<char> m_control{};
+    std::vector<struct iovec> m_iovecs{};
+    std::vector<struct sockaddr_in> m_from{};
+    std::vector<struct mmsghdr> m_messages{};
+    std::vector<Datagram> m_datagrams{};
+
+    std::atomic<uint64_t> m_batches{0};
+    std::atomic<uint64_t> m_truncated{0};
+    std::atomic<bool> m_isRunning{false};
+    bool const m_isThreaded;
+    std::thread m_receiver{};
+};
+
+#endif
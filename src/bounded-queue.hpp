@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Bounded lock-free multi-producer/multi-consumer queue (after D. Vyukov).
+ * Elements live in preallocated cells and are filled and consumed in place,
+ * so element types that keep their capacity (std::vector) are reused
+ * without allocating.
+ */
+template <typename T>
+class BoundedQueue {
+   private:
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue(BoundedQueue &&)      = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(BoundedQueue &&) = delete;
+
+   public:
+    /**
+     * @param capacity Number of cells, rounded up to a power of two.
+     */
+    explicit BoundedQueue(std::size_t capacity) noexcept
+    {
+        std::size_t size{2};
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_mask = size - 1;
+        m_cells.reset(new Cell[size]);
+        for (std::size_t i = 0; i < size; i++) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    ~BoundedQueue() = default;
+
+   public:
+    /**
+     * Calls fill(T&) on a free cell; returns false without blocking when full.
+     */
+    template <typename F>
+    bool tryPush(F &&fill) noexcept
+    {
+        std::size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &m_cells[position & m_mask];
+            std::size_t const sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t const diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if ( 0 == diff ){
+                if ( m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed) ){
+                    break;
+                }
+            }
+            else if ( diff < 0 ){
+                return false;
+            }
+            else{
+                position = m_enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        fill(cell->value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Calls consume(T&) on the oldest element; returns false when empty.
+     */
+    template <typename F>
+    bool tryPop(F &&consume) noexcept
+    {
+        std::size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &m_cells[position & m_mask];
+            std::size_t const sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t const diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if ( 0 == diff ){
+                if ( m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed) ){
+                    break;
+                }
+            }
+            else if ( diff < 0 ){
+                return false;
+            }
+            else{
+                position = m_dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        consume(cell->value);
+        cell->sequence.store(position + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+   private:
+    struct Cell {
+        std::atomic<std::size_t> sequence{0};
+        T value{};
+    };
+
+    std::size_t m_mask{0};
+    std::unique_ptr<Cell[]> m_cells{};
+    // Producers and consumers advance on separate cache lines.
+    char m_padding0[64]{};
+    std::atomic<std::size_t> m_enqueuePosition{0};
+    char m_padding1[64]{};
+    std::atomic<std::size_t> m_dequeuePosition{0};
+};
+
+#endif
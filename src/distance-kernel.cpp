@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "distance-kernel.hpp"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+void EntityStore::clear() noexcept
+{
+    xs.clear();
+    ys.clear();
+    radii2.clear();
+}
+
+void EntityStore::add(float x, float y, float radius) noexcept
+{
+    xs.push_back(x);
+    ys.push_back(y);
+    radii2.push_back(radius * radius);
+}
+
+uint32_t EntityStore::size() const noexcept
+{
+    return static_cast<uint32_t>(xs.size());
+}
+
+namespace {
+// Appends the indices base + bit for the set bits of mask.
+inline uint32_t appendHits(uint32_t mask, uint32_t base, uint32_t *hits, uint32_t nHits) noexcept {
+    while (mask != 0) {
+        hits[nHits++] = base + static_cast<uint32_t>(__builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+    return nHits;
+}
+
+// The same kernel for a shared or a per-entity radius; RADII_STRIDE is 0 or 1.
+template <uint32_t RADII_STRIDE>
+inline uint32_t kernel(float x, float y, const float *xs, const float *ys, const float *radii2, uint32_t count, uint32_t *hits) noexcept {
+    uint32_t nHits{0};
+    uint32_t i{0};
+#if defined(__AVX2__)
+    __m256 const vx = _mm256_set1_ps(x);
+    __m256 const vy = _mm256_set1_ps(y);
+    __m256 vr2 = _mm256_set1_ps(radii2[0]);
+    for (; i + 8 <= count; i += 8) {
+        __m256 const dx = _mm256_sub_ps(vx, _mm256_loadu_ps(xs + i));
+        __m256 const dy = _mm256_sub_ps(vy, _mm256_loadu_ps(ys + i));
+        __m256 const d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        if ( RADII_STRIDE != 0 ){
+            vr2 = _mm256_loadu_ps(radii2 + i);
+        }
+        uint32_t const mask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(d2, vr2, _CMP_LE_OQ)));
+        nHits = appendHits(mask, i, hits, nHits);
+    }
+#elif defined(__SSE2__)
+    __m128 const vx = _mm_set1_ps(x);
+    __m128 const vy = _mm_set1_ps(y);
+    __m128 vr2 = _mm_set1_ps(radii2[0]);
+    for (; i + 4 <= count; i += 4) {
+        __m128 const dx = _mm_sub_ps(vx, _mm_loadu_ps(xs + i));
+        __m128 const dy = _mm_sub_ps(vy, _mm_loadu_ps(ys + i));
+        __m128 const d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        if ( RADII_STRIDE != 0 ){
+            vr2 = _mm_loadu_ps(radii2 + i);
+        }
+        uint32_t const mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(d2, vr2)));
+        nHits = appendHits(mask, i, hits, nHits);
+    }
+#endif
+    for (; i < count; i++) {
+        float const dx = x - xs[i];
+        float const dy = y - ys[i];
+        if ( dx * dx + dy * dy <= radii2[i * RADII_STRIDE] ){
+            hits[nHits++] = i;
+        }
+    }
+    return nHits;
+}
+} // namespace
+
+uint32_t withinRadius(float x, float y, const float *xs, const float *ys, float radius2, uint32_t count, uint32_t *hits) noexcept
+{
+    return kernel<0>(x, y, xs, ys, &radius2, count, hits);
+}
+
+uint32_t withinRadii(float x, float y, const float *xs, const float *ys, const float *radii2, uint32_t count, uint32_t *hits) noexcept
+{
+    if ( count == 0 ){
+        return 0;
+    }
+    return kernel<1>(x, y, xs, ys, radii2, count, hits);
+}
+
+const char *distanceKernelName() noexcept
+{
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
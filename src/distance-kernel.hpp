@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DISTANCE_KERNEL_HPP
+#define DISTANCE_KERNEL_HPP
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Positions and squared radii of entities in structure-of-arrays layout,
+ * so that the distance kernel can process several entities per instruction.
+ */
+struct EntityStore {
+    std::vector<float> xs{};
+    std::vector<float> ys{};
+    std::vector<float> radii2{};
+
+    void clear() noexcept;
+    void add(float x, float y, float radius) noexcept;
+    uint32_t size() const noexcept;
+};
+
+/**
+ * Writes to hits the indices i < count with
+ * (x - xs[i])^2 + (y - ys[i])^2 <= radius2, in ascending order.
+ * hits must have room for count entries.
+ *
+ * @return Number of indices written.
+ */
+uint32_t withinRadius(float x, float y, const float *xs, const float *ys, float radius2, uint32_t count, uint32_t *hits) noexcept;
+
+/**
+ * As withinRadius, but with an individual squared radius per entity.
+ */
+uint32_t withinRadii(float x, float y, const float *xs, const float *ys, const float *radii2, uint32_t count, uint32_t *hits) noexcept;
+
+/**
+ * @return Instruction set used by the kernels: "avx2", "sse2" or "scalar".
+ */
+const char *distanceKernelName() noexcept;
+
+#endif
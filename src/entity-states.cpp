@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "entity-states.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <endian.h>
+
+namespace {
+// Offsets into the header.
+constexpr std::size_t VERSION_OFFSET{0};
+constexpr std::size_t ENTITY_SIZE_OFFSET{1};
+constexpr std::size_t COUNT_OFFSET{2};
+constexpr std::size_t QUANTUM_OFFSET{4};
+constexpr std::size_t Z_OFFSET{8};
+
+void putFloat(char *out, float v) noexcept
+{
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    bits = htole32(bits);
+    std::memcpy(out, &bits, sizeof(bits));
+}
+
+float getFloat(const char *in) noexcept
+{
+    uint32_t bits;
+    std::memcpy(&bits, in, sizeof(bits));
+    bits = le32toh(bits);
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+int16_t quantize(float v) noexcept
+{
+    float const quanta = std::round(v / ENTITY_STATES_QUANTUM);
+    return static_cast<int16_t>(std::max(-32767.0f, std::min(32767.0f, quanta)));
+}
+}
+
+void beginEntityStates(std::string &out, float z) noexcept
+{
+    out.assign(ENTITY_STATES_HEADER_SIZE, '\0');
+    out[VERSION_OFFSET] = static_cast<char>(ENTITY_STATES_VERSION);
+    out[ENTITY_SIZE_OFFSET] = static_cast<char>(ENTITY_STATE_SIZE);
+    putFloat(&out[QUANTUM_OFFSET], ENTITY_STATES_QUANTUM);
+    putFloat(&out[Z_OFFSET], z);
+}
+
+bool appendEntityState(std::string &out, uint32_t senderStamp, float x, float y) noexcept
+{
+    if ( out.size() >= ENTITY_STATES_HEADER_SIZE + ENTITY_STATES_MAX_COUNT * ENTITY_STATE_SIZE ){
+        return false;
+    }
+    char entity[ENTITY_STATE_SIZE];
+    uint32_t const stamp = htole32(senderStamp);
+    uint16_t const qx = htole16(static_cast<uint16_t>(quantize(x)));
+    uint16_t const qy = htole16(static_cast<uint16_t>(quantize(y)));
+    std::memcpy(entity, &stamp, sizeof(stamp));
+    std::memcpy(entity + 4, &qx, sizeof(qx));
+    std::memcpy(entity + 6, &qy, sizeof(qy));
+    out.append(entity, sizeof(entity));
+    return true;
+}
+
+uint32_t endEntityStates(std::string &out) noexcept
+{
+    uint16_t const count = static_cast<uint16_t>((out.size() - ENTITY_STATES_HEADER_SIZE) / ENTITY_STATE_SIZE);
+    uint16_t const encoded = htole16(count);
+    std::memcpy(&out[COUNT_OFFSET], &encoded, sizeof(encoded));
+    return count;
+}
+
+bool unpackEntityStates(const std::string &data, float &z, std::vector<EntityState> &states) noexcept
+{
+    states.clear();
+    // Later versions only append fields, which are skipped via the entity size.
+    if ( data.size() < ENTITY_STATES_HEADER_SIZE || ENTITY_STATES_VERSION > static_cast<uint8_t>(data[VERSION_OFFSET]) ){
+        return false;
+    }
+    std::size_t const entitySize = static_cast<uint8_t>(data[ENTITY_SIZE_OFFSET]);
+    uint16_t count;
+    std::memcpy(&count, &data[COUNT_OFFSET], sizeof(count));
+    count = le16toh(count);
+    if ( entitySize < ENTITY_STATE_SIZE || data.size() < ENTITY_STATES_HEADER_SIZE + count * entitySize ){
+        return false;
+    }
+    float const quantum = getFloat(&data[QUANTUM_OFFSET]);
+    z = getFloat(&data[Z_OFFSET]);
+    const char *entity = data.data() + ENTITY_STATES_HEADER_SIZE;
+    for (uint16_t i = 0; i < count; i++, entity += entitySize) {
+        uint32_t stamp;
+        uint16_t qx;
+        uint16_t qy;
+        std::memcpy(&stamp, entity, sizeof(stamp));
+        std::memcpy(&qx, entity + 4, sizeof(qx));
+        std::memcpy(&qy, entity + 6, sizeof(qy));
+        states.push_back(EntityState{le32toh(stamp),
+                                     static_cast<int16_t>(le16toh(qx)) * quantum,
+                                     static_cast<int16_t>(le16toh(qy)) * quantum});
+    }
+    return true;
+}
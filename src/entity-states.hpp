@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENTITY_STATES_HPP
+#define ENTITY_STATES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Packed positions of many entities for opendlv.sim.EntityStates::data, so
+ * that a subscriber gets the whole scene from one envelope instead of one
+ * Frame per entity. All values are little-endian:
+ *
+ *   header (12 bytes): uint8 version, uint8 bytes per entity, uint16 count,
+ *                      float meters per quantum, float z of all entities
+ *   per entity:        uint32 sender stamp, int16 x, int16 y in quanta
+ *
+ * Decoders accept any version from ENTITY_STATES_VERSION on and skip bytes
+ * they do not know at the end of an entity, so later versions may append
+ * fields to it but not change the ones above.
+ */
+constexpr uint8_t ENTITY_STATES_VERSION{1};
+constexpr std::size_t ENTITY_STATES_HEADER_SIZE{12};
+constexpr std::size_t ENTITY_STATE_SIZE{8};
+// 1 mm resolution, positions saturate at +-32.767 m.
+constexpr float ENTITY_STATES_QUANTUM{0.001f};
+constexpr float ENTITY_STATES_MAX_POSITION{32767 * ENTITY_STATES_QUANTUM};
+// Entities per block, so that its envelope stays below the 65507 byte UDP
+// payload limit (64 kB of entities plus header and envelope fields); larger
+// scenes are split into several blocks.
+constexpr uint32_t ENTITY_STATES_MAX_COUNT{8000};
+
+struct EntityState {
+    uint32_t senderStamp;
+    float x;
+    float y;
+};
+
+/**
+ * Starts a block in out, which is cleared but keeps its capacity.
+ */
+void beginEntityStates(std::string &out, float z) noexcept;
+
+/**
+ * Adds an entity, its position rounded to quanta.
+ *
+ * @return false, without adding it, if the block already holds ENTITY_STATES_MAX_COUNT.
+ */
+bool appendEntityState(std::string &out, uint32_t senderStamp, float x, float y) noexcept;
+
+/**
+ * Writes the entity count into the header.
+ *
+ * @return Number of entities in the block.
+ */
+uint32_t endEntityStates(std::string &out) noexcept;
+
+/**
+ * Reference decoder for subscribers.
+ *
+ * @return false if data is truncated, of an older version or has entities
+ *         shorter than ENTITY_STATE_SIZE; states is then empty.
+ */
+bool unpackEntityStates(const std::string &data, float &z, std::vector<EntityState> &states) noexcept;
+
+#endif
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "envelope-encoder.hpp"
+
+#include <cstring>
+
+namespace {
+// Protobuf wire types as used by cluon::ToProtoVisitor.
+constexpr uint8_t VARINT{0};
+constexpr uint8_t LENGTH_DELIMITED{2};
+constexpr uint8_t FOUR_BYTES{5};
+
+// Envelope header, one nested TimeStamp at most and the fixed fields.
+constexpr std::size_t MAX_ENVELOPE_OVERHEAD{5 + 6 + 6 + 3 * (2 + 12) + 6};
+
+inline std::size_t putVarInt(char *out, uint64_t v) noexcept
+{
+    std::size_t size{0};
+    while (0x7f < v) {
+        out[size++] = static_cast<char>((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    out[size++] = static_cast<char>(v);
+    return size;
+}
+
+inline std::size_t putKey(char *out, uint32_t id, uint8_t wireType) noexcept
+{
+    return putVarInt(out, (static_cast<uint64_t>(id) << 3) | wireType);
+}
+
+inline uint32_t toZigZag32(int32_t v) noexcept
+{
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+inline std::size_t putFloat(char *out, uint32_t id, float v) noexcept
+{
+    std::size_t size = putKey(out, id, FOUR_BYTES);
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    bits = htole32(bits);
+    std::memcpy(out + size, &bits, sizeof(bits));
+    return size + sizeof(bits);
+}
+
+inline std::size_t putTimeStamp(char *out, uint32_t id, const cluon::data::TimeStamp &ts) noexcept
+{
+    char nested[12];
+    std::size_t nestedSize = putKey(nested, 1, VARINT);
+    nestedSize += putVarInt(nested + nestedSize, toZigZag32(ts.seconds()));
+    nestedSize += putKey(nested + nestedSize, 2, VARINT);
+    nestedSize += putVarInt(nested + nestedSize, toZigZag32(ts.microseconds()));
+
+    std::size_t size = putKey(out, id, LENGTH_DELIMITED);
+    size += putVarInt(out + size, nestedSize);
+    std::memcpy(out + size, nested, nestedSize);
+    return size + nestedSize;
+}
+
+// Messages of a uint32 field 1 and a bytes field 2 (LocalPath, EntityStates).
+inline std::size_t encodeCountAndBytes(uint32_t count, const std::string &data, char *out) noexcept
+{
+    std::size_t size = putKey(out, 1, VARINT);
+    size += putVarInt(out + size, count);
+    size += putKey(out + size, 2, LENGTH_DELIMITED);
+    size += putVarInt(out + size, data.size());
+    std::memcpy(out + size, data.data(), data.size());
+    return size + data.size();
+}
+} // namespace
+
+std::size_t encodePayload(const opendlv::sim::Frame &frame, char *out) noexcept
+{
+    std::size_t size = putFloat(out, 1, frame.x());
+    size += putFloat(out + size, 2, frame.y());
+    size += putFloat(out + size, 3, frame.z());
+    size += putFloat(out + size, 4, frame.roll());
+    size += putFloat(out + size, 5, frame.pitch());
+    size += putFloat(out + size, 6, frame.yaw());
+    return size;
+}
+
+std::size_t encodePayload(const opendlv::sim::KinematicState &state, char *out) noexcept
+{
+    std::size_t size = putFloat(out, 1, state.vx());
+    size += putFloat(out + size, 2, state.vy());
+    size += putFloat(out + size, 3, state.vz());
+    size += putFloat(out + size, 4, state.rollRate());
+    size += putFloat(out + size, 5, state.pitchRate());
+    size += putFloat(out + size, 6, state.yawRate());
+    return size;
+}
+
+std::size_t encodePayload(const opendlv::logic::sensation::TargetFoundState &state, char *out) noexcept
+{
+    std::size_t size = putKey(out, 1, VARINT);
+    size += putVarInt(out + size, state.target_found_count());
+    size += putKey(out + size, 2, VARINT);
+    size += putVarInt(out + size, state.is_chpad_found());
+    return size;
+}
+
+std::size_t encodeLocalPath(uint32_t length, const std::string &data, char *out) noexcept
+{
+    return encodeCountAndBytes(length, data, out);
+}
+
+std::size_t encodeEntityStates(uint32_t count, const std::string &data, char *out) noexcept
+{
+    return encodeCountAndBytes(count, data, out);
+}
+
+std::size_t appendEnvelope(std::vector<char> &buffer, int32_t dataType, const char *payload, std::size_t payloadSize,
+    const cluon::data::TimeStamp &sent, const cluon::data::TimeStamp &sampleTimeStamp, uint32_t senderStamp) noexcept
+{
+    std::size_t const begin = buffer.size();
+    buffer.resize(begin + MAX_ENVELOPE_OVERHEAD + payloadSize);
+    char *out = buffer.data() + begin;
+
+    // The OD4 header (0x0D 0xA4 + 3 byte length) is filled in last.
+    std::size_t size{5};
+    size += putKey(out + size, 1, VARINT);
+    size += putVarInt(out + size, toZigZag32(dataType));
+    size += putKey(out + size, 2, LENGTH_DELIMITED);
+    size += putVarInt(out + size, payloadSize);
+    std::memcpy(out + size, payload, payloadSize);
+    size += payloadSize;
+    size += putTimeStamp(out + size, 3, sent);
+    size += putTimeStamp(out + size, 4, cluon::data::TimeStamp{});
+    size += putTimeStamp(out + size, 5, sampleTimeStamp);
+    size += putKey(out + size, 6, VARINT);
+    size += putVarInt(out + size, senderStamp);
+
+    std::size_t const length = size - 5;
+    out[0] = static_cast<char>(0x0D);
+    out[1] = static_cast<char>(0xA4);
+    out[2] = static_cast<char>(length & 0xff);
+    out[3] = static_cast<char>((length >> 8) & 0xff);
+    out[4] = static_cast<char>((length >> 16) & 0xff);
+
+    buffer.resize(begin + size);
+    return size;
+}
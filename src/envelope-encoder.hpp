@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENVELOPE_ENCODER_HPP
+#define ENVELOPE_ENCODER_HPP
+
+#include "cluon-complete.hpp"
+#include "opendlv-standard-message-set.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Byte-identical replacement of ToProtoVisitor + serializeEnvelope for the
+ * messages published every tick. The envelope is written straight into the
+ * caller's buffer; once its capacity covers a tick, encoding performs no
+ * heap allocations.
+ */
+
+// Upper bound of the encoded payloads below.
+constexpr std::size_t MAX_FIXED_PAYLOAD_SIZE{32};
+
+std::size_t encodePayload(const opendlv::sim::Frame &frame, char *out) noexcept;
+std::size_t encodePayload(const opendlv::sim::KinematicState &state, char *out) noexcept;
+std::size_t encodePayload(const opendlv::logic::sensation::TargetFoundState &state, char *out) noexcept;
+
+// A LocalPath needs this many bytes on top of its data.
+constexpr std::size_t LOCAL_PATH_OVERHEAD{12};
+
+/**
+ * Encodes a LocalPath from its fields; LocalPath::data() returns a copy, so
+ * callers that must not allocate keep the data themselves.
+ */
+std::size_t encodeLocalPath(uint32_t length, const std::string &data, char *out) noexcept;
+
+// An EntityStates needs this many bytes on top of its data.
+constexpr std::size_t ENTITY_STATES_OVERHEAD{12};
+
+/**
+ * Encodes an EntityStates from its fields, like encodeLocalPath().
+ */
+std::size_t encodeEntityStates(uint32_t count, const std::string &data, char *out) noexcept;
+
+/**
+ * Appends one OD4 envelope (header included) with the given payload to buffer.
+ *
+ * @return Bytes appended.
+ */
+std::size_t appendEnvelope(std::vector<char> &buffer, int32_t dataType, const char *payload, std::size_t payloadSize,
+    const cluon::data::TimeStamp &sent, const cluon::data::TimeStamp &sampleTimeStamp, uint32_t senderStamp) noexcept;
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "envelope-filter.hpp"
+
+namespace {
+constexpr std::size_t OD4_HEADER_SIZE{5};
+// Protobuf wire types.
+constexpr uint64_t VARINT{0};
+constexpr uint64_t EIGHT_BYTES{1};
+constexpr uint64_t LENGTH_DELIMITED{2};
+constexpr uint64_t FOUR_BYTES{5};
+
+// Reads a base 128 varint at pos; false if it runs past end.
+bool readVarInt(const uint8_t *data, std::size_t end, std::size_t &pos, uint64_t &v) noexcept
+{
+    v = 0;
+    for (uint32_t shift = 0; pos < end && shift < 64; shift += 7) {
+        uint8_t const byte = data[pos++];
+        v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ( 0 == (byte & 0x80) ){
+            return true;
+        }
+    }
+    return false;
+}
+} // namespace
+
+bool peekEnvelope(const char *data, std::size_t size, EnvelopeHeader &header) noexcept
+{
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+    if ( size < OD4_HEADER_SIZE || 0x0D != bytes[0] || 0xA4 != bytes[1] ){
+        return false;
+    }
+    std::size_t const length = static_cast<std::size_t>(bytes[2]) | (static_cast<std::size_t>(bytes[3]) << 8) | (static_cast<std::size_t>(bytes[4]) << 16);
+    std::size_t const end = OD4_HEADER_SIZE + length;
+    if ( end > size ){
+        return false;
+    }
+
+    header = EnvelopeHeader{0, 0, end};
+    std::size_t pos{OD4_HEADER_SIZE};
+    while (pos < end) {
+        uint64_t key;
+        uint64_t value{0};
+        if ( !readVarInt(bytes, end, pos, key) ){
+            return false;
+        }
+        uint64_t const wireType = key & 0x7;
+        if ( VARINT == wireType ){
+            if ( !readVarInt(bytes, end, pos, value) ){
+                return false;
+            }
+        }
+        else if ( LENGTH_DELIMITED == wireType ){
+            if ( !readVarInt(bytes, end, pos, value) || value > end - pos ){
+                return false;
+            }
+            pos += value;
+        }
+        else if ( EIGHT_BYTES == wireType || FOUR_BYTES == wireType ){
+            pos += (EIGHT_BYTES == wireType) ? 8 : 4;
+        }
+        else{
+            return false;
+        }
+        if ( 1 == (key >> 3) ){
+            // Zig-zag encoded sint32.
+            header.dataType = static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+        }
+        else if ( 6 == (key >> 3) ){
+            header.senderStamp = static_cast<uint32_t>(value);
+        }
+    }
+    return pos == end;
+}
+
+void EnvelopeFilter::accept(int32_t dataType) noexcept
+{
+    m_entries.push_back(Entry{dataType, 0, true, false});
+}
+
+void EnvelopeFilter::accept(int32_t dataType, uint32_t senderStamp, bool isCoalesced) noexcept
+{
+    m_entries.push_back(Entry{dataType, senderStamp, false, isCoalesced});
+}
+
+bool EnvelopeFilter::isAccepted(int32_t dataType, uint32_t senderStamp) const noexcept
+{
+    return 0 <= indexOf(dataType, senderStamp);
+}
+
+bool EnvelopeFilter::isAcceptedType(int32_t dataType) const noexcept
+{
+    for (Entry const &entry : m_entries) {
+        if ( entry.dataType == dataType ){
+            return true;
+        }
+    }
+    return false;
+}
+
+int32_t EnvelopeFilter::indexOf(int32_t dataType, uint32_t senderStamp) const noexcept
+{
+    for (std::size_t i = 0; i < m_entries.size(); i++) {
+        Entry const &entry = m_entries[i];
+        if ( entry.dataType == dataType && (entry.isAnySender || entry.senderStamp == senderStamp) ){
+            return static_cast<int32_t>(i);
+        }
+    }
+    return -1;
+}
+
+bool EnvelopeFilter::isCoalesced(int32_t index) const noexcept
+{
+    return m_entries[static_cast<std::size_t>(index)].isCoalesced;
+}
+
+uint32_t EnvelopeFilter::size() const noexcept
+{
+    return static_cast<uint32_t>(m_entries.size());
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENVELOPE_FILTER_HPP
+#define ENVELOPE_FILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Routing fields of one serialized OD4 envelope.
+ */
+struct EnvelopeHeader {
+    int32_t dataType;
+    uint32_t senderStamp;
+    // Bytes of the envelope including the 5 byte OD4 header.
+    std::size_t size;
+};
+
+/**
+ * Reads dataType and senderStamp of the OD4 envelope at the start of data by
+ * skipping over the other fields, without copying or decoding the payload.
+ *
+ * @return false if data does not start with a complete, well formed envelope.
+ */
+bool peekEnvelope(const char *data, std::size_t size, EnvelopeHeader &header) noexcept;
+
+/**
+ * The (dataType, senderStamp) pairs a receiver subscribes to, so that other
+ * envelopes can be dropped after peekEnvelope() instead of being decoded.
+ * Pairs of which only the latest value matters can be marked as coalesced:
+ * of several envelopes received in one batch, only the newest is decoded.
+ */
+class EnvelopeFilter {
+   public:
+    /**
+     * Accepts dataType from any sender.
+     */
+    void accept(int32_t dataType) noexcept;
+    void accept(int32_t dataType, uint32_t senderStamp, bool isCoalesced = false) noexcept;
+
+    bool isAccepted(int32_t dataType, uint32_t senderStamp) const noexcept;
+
+    /**
+     * @return true if dataType is accepted from at least one sender, so that a
+     * rejected envelope of that type comes from an unknown sender.
+     */
+    bool isAcceptedType(int32_t dataType) const noexcept;
+
+    /**
+     * @return Subscription matching the envelope, in [0, size()), or -1 if none does.
+     */
+    int32_t indexOf(int32_t dataType, uint32_t senderStamp) const noexcept;
+    bool isCoalesced(int32_t index) const noexcept;
+    uint32_t size() const noexcept;
+
+   private:
+    struct Entry {
+        int32_t dataType;
+        uint32_t senderStamp;
+        bool isAnySender;
+        bool isCoalesced;
+    };
+    // A handful of subscriptions, scanned linearly.
+    std::vector<Entry> m_entries{};
+};
+
+#endif
@@ -0,0 +1,596 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "episode.hpp"
+#include "ball-simulator-messages.hpp"
+#include "opendlv-standard-message-set.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace {
+// Bytes per direction of the shared memory transport.
+constexpr uint32_t SHM_RING_CAPACITY{1 << 20};
+// Lockstep releases whose steps did not run yet; receive handlers wait when full.
+constexpr std::size_t RELEASED_STEPS_CAPACITY{64};
+
+void appendFloat(std::string &out, float v) noexcept
+{
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    bits = htole32(bits);
+    out.append(reinterpret_cast<const char *>(&bits), sizeof(bits));
+}
+}
+
+Episode::Episode(uint16_t cid, const Scenario &scenario, const EpisodeOptions &options, std::function<void(Episode &)> onStep) noexcept
+    : m_cid{cid}
+    , m_scenario{scenario}
+    , m_onStep{std::move(onStep)}
+    , m_poses{options.droneStamps}
+    , m_hasFrame(options.droneStamps.size())
+    , m_world{scenario, static_cast<uint32_t>(options.droneStamps.size()), options.lookAhead}
+    , m_releasedSteps{RELEASED_STEPS_CAPACITY}
+    , m_dt{options.dt}
+    , m_keyframePeriod{options.keyframePeriod / 1000.0}
+    , m_sinceKeyframe{m_keyframePeriod}
+    , m_isTargetPending(scenario.targets.size())
+    , m_targetEnvelopeSizes(scenario.targets.size())
+    , m_isBulk{options.isBulk}
+    , m_closeBallStartTimes(options.droneStamps.size() * scenario.balls.size())
+    , m_latencyReportPeriod{options.latencyReportPeriod}
+    , m_nextLatencyReport{std::chrono::steady_clock::now() + m_latencyReportPeriod}
+    , m_isOffline{options.isOffline}
+    , m_shmIn{options.isSharedMemory ? new ShmRing{"ball-sim-" + std::to_string(cid) + "-in", SHM_RING_CAPACITY} : nullptr}
+    , m_shmOut{options.isSharedMemory ? new ShmRing{"ball-sim-" + std::to_string(cid) + "-out", SHM_RING_CAPACITY} : nullptr}
+    , m_recorder{options.recFile.empty() ? nullptr : new Recorder{options.recFile}}
+    , m_publisher{cid, options.isSingleDatagram, !options.isOffline}
+    , m_isLockstep{options.isLockstep}
+{
+    bool const isStepOnFrame{options.isStepOnFrame};
+    bool const isCoalescing{options.isCoalescing && !options.isLockstep};
+    m_inputs.drones.resize(m_poses.size());
+    m_poseReceived.resize(m_poses.size());
+
+    // Every handler is reachable over UDP and, if enabled, over the shared memory ring;
+    // the receivers only decode the sender stamps it subscribes to.
+    auto addHandler = [this](int32_t dataType, std::vector<uint32_t> const &senderStamps, bool isCoalesced, std::function<void(cluon::data::Envelope &&)> handler){
+        m_handlers[dataType] = std::move(handler);
+        for (uint32_t const senderStamp : senderStamps) {
+            m_filter.accept(dataType, senderStamp, isCoalesced);
+        }
+        if ( senderStamps.empty() ){
+            m_filter.accept(dataType);
+        }
+    };
+
+    auto onFrame{[this, isStepOnFrame](cluon::data::Envelope &&envelope)
+    {
+        // Only frames of tracked drones pass the receive filter.
+        int32_t const drone = m_poses.indexOf(envelope.senderStamp());
+        if ( drone >= 0 ){
+            int64_t const timestamp = cluon::time::toMicroseconds(envelope.sampleTimeStamp());
+            int64_t const received = cluon::time::toMicroseconds(envelope.received());
+            auto frame = cluon::extractMessage<opendlv::sim::Frame>(std::move(envelope));
+            m_poses.update(static_cast<uint32_t>(drone), PoseTable::Pose{frame.x(), frame.y(), timestamp, received});
+            m_isReady.store(true, std::memory_order_release);
+
+            // Release the step once the whole swarm reported its pose.
+            if ( isStepOnFrame && 0 == m_hasFrame[drone] ){
+                m_hasFrame[drone] = 1;
+                m_nFramesSinceStep += 1;
+                if ( m_nFramesSinceStep == m_poses.size() ){
+                    std::fill(m_hasFrame.begin(), m_hasFrame.end(), 0);
+                    m_nFramesSinceStep = 0;
+                    release(1);
+                }
+            }
+        }
+    }};
+    addHandler(opendlv::sim::Frame::ID(), options.droneStamps, isCoalescing, onFrame);
+
+    auto onStepRequest = [this](cluon::data::Envelope &&env){
+        auto stepRequest = cluon::extractMessage<opendlv::sim::StepRequest>(std::move(env));
+        release(std::max<uint32_t>(1, stepRequest.count()));
+    };
+    if ( options.isLockstep && !isStepOnFrame ){
+        addHandler(opendlv::sim::StepRequest::ID(), {}, false, onStepRequest);
+    }
+
+    // Other sender stamps are counted as unknown senders by the receive filter.
+    auto onDistRead = [this](cluon::data::Envelope &&env){
+        // Now, we unpack the cluon::data::Envelope to get the desired DistanceReading.
+        opendlv::logic::action::PreviewPoint pPtmessage = cluon::extractMessage<opendlv::logic::action::PreviewPoint>(std::move(env));
+
+        // Store distance readings.
+        m_dist_obs.store(pPtmessage.distance(), std::memory_order_release);
+    };
+    addHandler(opendlv::logic::action::PreviewPoint::ID(), {1}, isCoalescing, onDistRead);
+
+    auto onCFlagRead = [this](cluon::data::Envelope &&env){
+        opendlv::logic::sensation::CompleteFlag cFlagessage = cluon::extractMessage<opendlv::logic::sensation::CompleteFlag>(std::move(env));
+        m_taskCompleted.store(cFlagessage.task_completed() == 1, std::memory_order_release);
+    };
+    addHandler(opendlv::logic::sensation::CompleteFlag::ID(), {0}, isCoalescing, onCFlagRead);
+
+    // Explicit start message for UAV sides that wait for the simulator before sending poses.
+    // Only a tracked drone's 'start' counts, not other services or the 'ready' of a simulator.
+    auto onStart = [this](cluon::data::Envelope &&env){
+        auto state = cluon::extractMessage<opendlv::system::SystemOperationState>(std::move(env));
+        if ( 0 == state.code() && "start" == state.description() ){
+            m_isReady.store(true, std::memory_order_release);
+        }
+    };
+    addHandler(opendlv::system::SystemOperationState::ID(), options.droneStamps, false, onStart);
+    m_udpLatest.resize(m_filter.size(), LatestEnvelope{nullptr, 0, cluon::data::TimeStamp{}, {}});
+    m_shmLatest.resize(m_filter.size(), LatestEnvelope{nullptr, 0, cluon::data::TimeStamp{}, {}});
+
+    if ( m_shmOut ){
+        m_publisher.addSink([this](const char *data, std::size_t size){ m_shmOut->push(data, size); });
+    }
+    if ( m_recorder ){
+        if ( !m_recorder->isValid() ){
+            std::cerr << "Could not open " << options.recFile << " for recording..." << std::endl;
+        }
+        m_publisher.addSink([this](const char *data, std::size_t size){ m_recorder->record(data, size); });
+    }
+
+    if ( m_shmIn && m_shmIn->isValid() ){
+        m_isShmReceiving.store(true);
+        m_shmReceiver = std::thread(&Episode::receiveFromSharedMemory, this);
+    }
+
+    // Receive like OD4Session, but skip our own datagrams which are sent from the publisher's port.
+    auto onDatagrams = [this](const BatchReceiver::Datagram *datagrams, std::size_t count){
+        receiveDatagrams(datagrams, count, m_udpLatest, m_isDrainedOnTick);
+    };
+    if ( !options.isOffline ){
+        m_isDrainedOnTick = isCoalescing;
+        m_receiver.reset(new BatchReceiver{"225.0.0." + std::to_string(cid), 12175, m_publisher.sendFromPort(), onDatagrams, !m_isDrainedOnTick});
+    }
+}
+
+Episode::~Episode()
+{
+    m_isShmReceiving.store(false);
+    if ( m_shmReceiver.joinable() ){
+        m_shmReceiver.join();
+    }
+}
+
+bool Episode::isRunning() noexcept
+{
+    return m_receiver && m_receiver->isRunning();
+}
+
+uint16_t Episode::cid() const noexcept
+{
+    return m_cid;
+}
+
+LockstepTrigger &Episode::lockstep() noexcept
+{
+    return m_lockstep;
+}
+
+const EpisodeMetrics &Episode::metrics() const noexcept
+{
+    return m_metrics;
+}
+
+QueueDepths Episode::queueDepths() const noexcept
+{
+    return QueueDepths{m_lockstep.pendingSteps(),
+                       m_recorder ? m_recorder->backlog() : 0,
+                       m_recorder ? m_recorder->dropped() : 0,
+                       m_shmOut ? m_shmOut->dropped() : 0,
+                       m_receiver ? m_receiver->batches() : 0,
+                       m_receiver ? m_receiver->truncated() : 0,
+                       m_publisher.sendErrors()};
+}
+
+bool Episode::isReady() noexcept
+{
+    if ( m_isDrainedOnTick ){
+        std::lock_guard<std::mutex> lck(m_tickMutex);
+        drainReceiver();
+    }
+    return m_isReady.load(std::memory_order_acquire);
+}
+
+void Episode::announceStart() noexcept
+{
+    std::lock_guard<std::mutex> lck(m_tickMutex);
+    opendlv::system::SystemOperationState state;
+    state.code(0);
+    state.description(m_isReady.load(std::memory_order_acquire) ? "ready" : "ready after start timeout");
+    m_publisher.add(state, cluon::data::TimeStamp{});
+    m_publisher.flush();
+    increment(m_metrics.sent[EpisodeMetrics::SYSTEM_OPERATION_STATE]);
+}
+
+void Episode::dispatch(cluon::data::Envelope &&envelope) noexcept
+{
+    if ( m_recorder ){
+        std::string const data{cluon::serializeEnvelope(cluon::data::Envelope{envelope})};
+        m_recorder->record(data.data(), data.size());
+    }
+
+    // UDP and shared memory deliver on different threads; handlers assume a single writer.
+    std::lock_guard<std::mutex> lck(m_receiveMutex);
+    increment(m_metrics.received[EpisodeMetrics::messageTypeOf(envelope.dataType())]);
+    auto handler = m_handlers.find(envelope.dataType());
+    if ( handler != m_handlers.end() ){
+        handler->second(std::move(envelope));
+    }
+    else{
+        increment(m_metrics.unhandledTypes);
+    }
+}
+
+void Episode::receiveFromSharedMemory() noexcept
+{
+    auto onRecord = [this](const char *data, std::size_t size){
+        BatchReceiver::Datagram const datagram{data, size, cluon::time::now()};
+        receiveDatagrams(&datagram, 1, m_shmLatest, false);
+    };
+    while (m_isShmReceiving.load()) {
+        m_shmIn->waitForData(std::chrono::milliseconds(100));
+        m_shmIn->drain(onRecord);
+    }
+}
+
+void Episode::receiveDatagrams(const BatchReceiver::Datagram *datagrams, std::size_t count, std::vector<LatestEnvelope> &latest, bool isCopied) noexcept
+{
+    // A datagram may carry several envelopes back to back; only subscribed ones are decoded,
+    // and of coalesced subscriptions only the newest one of the batch, or of the drain if copied.
+    for (std::size_t i = 0; i < count; i++) {
+        const char *data = datagrams[i].data;
+        std::size_t size = datagrams[i].size;
+        EnvelopeHeader header;
+        while (size > 0 && peekEnvelope(data, size, header)) {
+            int32_t const subscription = m_filter.indexOf(header.dataType, header.senderStamp);
+            if ( subscription < 0 ){
+                countRejected(header.dataType);
+            }
+            else if ( m_filter.isCoalesced(subscription) ){
+                LatestEnvelope &entry = latest[static_cast<std::size_t>(subscription)];
+                if ( nullptr != entry.data ){
+                    m_metrics.coalesced.fetch_add(1, std::memory_order_relaxed);
+                }
+                if ( isCopied ){
+                    entry.copy.assign(data, data + header.size);
+                    entry.data = entry.copy.data();
+                }
+                else{
+                    entry.data = data;
+                }
+                entry.size = header.size;
+                entry.received = datagrams[i].received;
+            }
+            else{
+                decodeAndDispatch(data, header.size, datagrams[i].received);
+            }
+            data += header.size;
+            size -= header.size;
+        }
+    }
+    if ( !isCopied ){
+        dispatchLatest(latest);
+    }
+}
+
+void Episode::dispatchLatest(std::vector<LatestEnvelope> &latest) noexcept
+{
+    for (LatestEnvelope &entry : latest) {
+        if ( nullptr != entry.data ){
+            decodeAndDispatch(entry.data, entry.size, entry.received);
+            entry.data = nullptr;
+        }
+    }
+}
+
+void Episode::drainReceiver() noexcept
+{
+    m_receiver->drain();
+    dispatchLatest(m_udpLatest);
+}
+
+void Episode::countRejected(int32_t dataType) noexcept
+{
+    if ( m_filter.isAcceptedType(dataType) ){
+        m_metrics.unknownSenders.fetch_add(1, std::memory_order_relaxed);
+    }
+    else{
+        m_metrics.filtered.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Episode::decodeAndDispatch(const char *data, std::size_t size, const cluon::data::TimeStamp &received) noexcept
+{
+    std::stringstream sstr{std::string(data, size)};
+    auto retVal = cluon::extractEnvelope(sstr);
+    if ( retVal.first ){
+        retVal.second.received(received);
+        dispatch(std::move(retVal.second));
+    }
+}
+
+void Episode::receive(cluon::data::Envelope &&envelope) noexcept
+{
+    // Same subscriptions as on the network, so that a recording's own outputs are not handled again.
+    if ( !m_filter.isAccepted(envelope.dataType(), envelope.senderStamp()) ){
+        countRejected(envelope.dataType());
+        return;
+    }
+    dispatch(std::move(envelope));
+}
+
+void Episode::addOutputSink(std::function<void(const char *, std::size_t)> sink) noexcept
+{
+    m_publisher.addSink(std::move(sink));
+}
+
+void Episode::printStatistics(std::ostream &out) noexcept
+{
+    uint64_t const deltaSkipped{m_metrics.deltaSkipped.load(std::memory_order_relaxed)};
+    if ( m_isLockstep || m_recorder || m_receiver || 0 < m_decisionTime.count() || 0 < deltaSkipped ){
+        out << " Episode cid " << m_cid << ":" << std::endl;
+    }
+    if ( 0 < m_decisionTime.count() ){
+        out << latencyReport();
+    }
+    if ( 0 < deltaSkipped ){
+        out << " Delta publishing: " << deltaSkipped << " target frames skipped, "
+            << m_metrics.deltaSavedBytes.load(std::memory_order_relaxed) << " bytes saved" << std::endl;
+    }
+    if ( m_receiver ){
+        out << " Receiver: " << m_receiver->batches() << " batches, "
+            << m_receiver->truncated() << " datagrams dropped as too long" << std::endl;
+    }
+    if ( 0 < m_publisher.sendErrors() ){
+        out << " Publisher: " << m_publisher.sendErrors() << " datagrams failed to send or messages failed to encode" << std::endl;
+    }
+    if ( m_isLockstep ){
+        m_lockstep.printStatistics(out);
+    }
+    if ( m_recorder ){
+        m_recorder->printStatistics(out);
+    }
+}
+
+void Episode::tick(uint32_t periods) noexcept
+{
+    std::lock_guard<std::mutex> lck(m_tickMutex);
+    if ( m_isDrainedOnTick ){
+        drainReceiver();
+    }
+    sampleInputs(m_inputs, m_poseReceived);
+    advance(m_dt * static_cast<float>(periods));
+}
+
+void Episode::release(uint32_t count) noexcept
+{
+    // Called by the receive handlers, which hold m_receiveMutex: no input changes meanwhile.
+    auto fill = [this, count](ReleasedSteps &released){
+        sampleInputs(released.inputs, released.poseReceived);
+        released.count = count;
+    };
+    while (!m_releasedSteps.tryPush(fill)) {
+        std::this_thread::yield();
+    }
+    m_lockstep.step(count);
+    m_onStep(*this);
+}
+
+void Episode::runPendingSteps() noexcept
+{
+    std::lock_guard<std::mutex> lck(m_tickMutex);
+    while (m_lockstep.waitForStep(std::chrono::milliseconds(0))) {
+        // Every release queued its inputs before adding its steps to the trigger.
+        auto take = [this](ReleasedSteps &released){
+            std::swap(m_inputs, released.inputs);
+            std::swap(m_poseReceived, released.poseReceived);
+            m_stepsOfRelease = released.count;
+        };
+        if ( 0 == m_stepsOfRelease && !m_releasedSteps.tryPop(take) ){
+            sampleInputs(m_inputs, m_poseReceived);
+            m_stepsOfRelease = 1;
+        }
+        m_stepsOfRelease -= 1;
+        advance(m_dt);
+    }
+}
+
+void Episode::sampleInputs(Inputs &inputs, std::vector<int64_t> &poseReceived) noexcept
+{
+    inputs.drones.resize(m_poses.size());
+    poseReceived.resize(m_poses.size());
+    for (uint32_t drone = 0; drone < m_poses.size(); drone++) {
+        PoseTable::Pose const pos = m_poses.pose(drone);
+        inputs.drones[drone] = DroneInput{pos.x, pos.y};
+        poseReceived[drone] = pos.received;
+    }
+    inputs.previewDistance = m_dist_obs.load(std::memory_order_acquire);
+    inputs.isTaskCompleted = m_taskCompleted.load(std::memory_order_acquire);
+}
+
+void Episode::advance(float dt) noexcept
+{
+    auto const tickStart = std::chrono::steady_clock::now();
+    int64_t const now = cluon::time::toMicroseconds(cluon::time::now());
+    for (int64_t const received : m_poseReceived) {
+        if ( !m_isOffline && 0 != received ){
+            m_poseAge.record((now - received) * 1000);
+        }
+    }
+
+    step(m_world, m_inputs, dt);
+    auto const decided = std::chrono::steady_clock::now();
+    m_decisionTime.record(std::chrono::duration_cast<std::chrono::nanoseconds>(decided - tickStart).count());
+
+    for (BallAlertEvent const &event : m_world.alertEvents) {
+        reportBallAlert(event);
+        if ( event.isClose ){
+            increment(m_metrics.ballAlerts);
+        }
+    }
+
+    // Targets only move on captures and resets: publish those moves and, every
+    // keyframe period, all targets again; the balls go out every tick.
+    m_sinceKeyframe += static_cast<double>(dt);
+    bool const isKeyframe{m_sinceKeyframe + 1.0e-9 >= m_keyframePeriod};
+    if ( isKeyframe ){
+        m_sinceKeyframe = 0.0;
+    }
+    uint32_t nTargetsSent{0};
+    cluon::data::TimeStamp sampleTime;
+    opendlv::sim::Frame frame;
+    frame.z(m_scenario.height);
+    for (std::size_t i = 0; i < m_scenario.targets.size() && !m_isBulk; i++) {
+        m_isTargetPending[i] |= m_world.isTargetMoved[i];
+        if ( isKeyframe || 0 != m_isTargetPending[i] ){
+            std::size_t const before{m_publisher.size()};
+            frame.x(m_world.targetPositions[i].x);
+            frame.y(m_world.targetPositions[i].y);
+            m_publisher.add(frame, sampleTime, m_scenario.targets[i].senderStamp);
+            m_targetEnvelopeSizes[i] = m_publisher.size() - before;
+            m_isTargetPending[i] = 0;
+            nTargetsSent += 1;
+        }
+        else{
+            increment(m_metrics.deltaSkipped);
+            increment(m_metrics.deltaSavedBytes, m_targetEnvelopeSizes[i]);
+        }
+    }
+    for (std::size_t i = 0; i < m_scenario.balls.size() && !m_isBulk; i++) {
+        frame.x(m_world.ballPositions[i].x);
+        frame.y(m_world.ballPositions[i].y);
+        m_publisher.add(frame, sampleTime, m_scenario.balls[i].senderStamp);
+    }
+    if ( m_isBulk ){
+        // Scenes above ENTITY_STATES_MAX_COUNT entities go out as several blocks, one datagram each.
+        uint32_t nBlocks{0};
+        auto addEntity = [this, &sampleTime, &nBlocks](uint32_t senderStamp, const Waypoint &position){
+            if ( !appendEntityState(m_entityData, senderStamp, position.x, position.y) ){
+                m_publisher.addEntityStates(endEntityStates(m_entityData), m_entityData, sampleTime);
+                nBlocks += 1;
+                beginEntityStates(m_entityData, m_scenario.height);
+                appendEntityState(m_entityData, senderStamp, position.x, position.y);
+            }
+        };
+        beginEntityStates(m_entityData, m_scenario.height);
+        for (std::size_t i = 0; i < m_scenario.targets.size(); i++) {
+            addEntity(m_scenario.targets[i].senderStamp, m_world.targetPositions[i]);
+        }
+        for (std::size_t i = 0; i < m_scenario.balls.size(); i++) {
+            addEntity(m_scenario.balls[i].senderStamp, m_world.ballPositions[i]);
+        }
+        m_publisher.addEntityStates(endEntityStates(m_entityData), m_entityData, sampleTime);
+        increment(m_metrics.sent[EpisodeMetrics::ENTITY_STATES], nBlocks + 1);
+    }
+    opendlv::sim::KinematicState kinematicState;
+    for (std::size_t i = 0; i < m_scenario.balls.size(); i++) {
+        kinematicState.vx(m_world.ballVelocities[i].vx);
+        kinematicState.vy(m_world.ballVelocities[i].vy);
+        m_publisher.add(kinematicState, sampleTime, m_scenario.balls[i].senderStamp);
+    }
+    for (std::size_t i = 0; i < m_scenario.balls.size() && m_world.lookAhead > 0; i++) {
+        m_lookAheadData.clear();
+        for (uint32_t k = 0; k < m_world.lookAhead; k++) {
+            Waypoint const &pose = lookAheadPose(m_world, i, k);
+            appendFloat(m_lookAheadData, pose.x);
+            appendFloat(m_lookAheadData, pose.y);
+            appendFloat(m_lookAheadData, m_scenario.height);
+        }
+        m_publisher.addLocalPath(m_world.lookAhead, m_lookAheadData, sampleTime, m_scenario.balls[i].senderStamp);
+    }
+
+    // One TargetFoundState per drone, sent with the sender stamp of its frames.
+    opendlv::logic::sensation::TargetFoundState tState;
+    for (uint32_t drone = 0; drone < m_poses.size(); drone++) {
+        tState.target_found_count(m_world.nTargetFoundTimers[drone]);
+        tState.is_chpad_found(m_world.isChpadFound[drone]);
+        m_publisher.add(tState, sampleTime, m_poses.senderStamp(drone));
+    }
+
+    if ( m_latencyReportPeriod.count() > 0 && decided >= m_nextLatencyReport ){
+        m_nextLatencyReport += m_latencyReportPeriod;
+        std::string const report{latencyReport()};
+        std::cout << report << std::flush;
+        opendlv::system::LogMessage logMessage;
+        logMessage.description(report);
+        m_publisher.add(logMessage, sampleTime);
+        increment(m_metrics.sent[EpisodeMetrics::LOG_MESSAGE]);
+    }
+    m_publisher.flush();
+
+    increment(m_metrics.ticks);
+    increment(m_metrics.captures, m_world.captures);
+    increment(m_metrics.sent[EpisodeMetrics::FRAME], m_isBulk ? 0 : nTargetsSent + m_scenario.balls.size());
+    increment(m_metrics.sent[EpisodeMetrics::KINEMATIC_STATE], m_scenario.balls.size());
+    increment(m_metrics.sent[EpisodeMetrics::LOCAL_PATH], (m_world.lookAhead > 0) ? m_scenario.balls.size() : 0);
+    increment(m_metrics.sent[EpisodeMetrics::TARGET_FOUND_STATE], m_poses.size());
+
+    auto const sent = std::chrono::steady_clock::now();
+    m_sendTime.record(std::chrono::duration_cast<std::chrono::nanoseconds>(sent - decided).count());
+    if ( !m_isOffline ){
+        int64_t const tickDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(sent - tickStart).count();
+        for (int64_t const received : m_poseReceived) {
+            if ( 0 != received ){
+                m_poseToPublish.record((now - received) * 1000 + tickDuration);
+            }
+        }
+    }
+}
+
+std::string Episode::latencyReport() const noexcept
+{
+    std::stringstream sstr;
+    sstr << " Latency cid " << m_cid << ":" << std::endl
+         << "  pose age          " << m_poseAge.summary() << std::endl
+         << "  decision          " << m_decisionTime.summary() << std::endl
+         << "  send              " << m_sendTime.summary() << std::endl
+         << "  pose to publish   " << m_poseToPublish.summary() << std::endl;
+    return sstr.str();
+}
+
+void Episode::reportBallAlert(const BallAlertEvent &event) noexcept
+{
+    auto &closeBallStartTime = m_closeBallStartTimes[event.drone * m_scenario.balls.size() + event.ball];
+    if ( event.isClose ){
+        std::cout << "Too close to the ball!! (drone " << m_poses.senderStamp(event.drone)
+                  << (event.isBetweenTicks ? ", between ticks" : "") << ")" << std::endl;
+        closeBallStartTime = std::chrono::system_clock::now();
+    }
+    else{
+        auto const closeBallEndTime = std::chrono::system_clock::now();
+        const std::chrono::duration<double> elapsed = closeBallEndTime - closeBallStartTime;
+        auto start_time_t = std::chrono::system_clock::to_time_t(closeBallStartTime);
+        auto end_time_t = std::chrono::system_clock::to_time_t(closeBallEndTime);
+
+        std::cout <<" Close ball with start time: " << std::ctime(&start_time_t) << std::endl;
+        std::cout <<" , end time: " << std::ctime(&end_time_t) << std::endl;
+        std::cout <<" , elapsed: " << elapsed.count() << " seconds(s)" << std::endl;
+    }
+}
@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EPISODE_HPP
+#define EPISODE_HPP
+
+#include "batch-publisher.hpp"
+#include "batch-receiver.hpp"
+#include "bounded-queue.hpp"
+#include "cluon-complete.hpp"
+#include "entity-states.hpp"
+#include "envelope-filter.hpp"
+#include "latency-histogram.hpp"
+#include "lockstep-trigger.hpp"
+#include "metrics.hpp"
+#include "pose-table.hpp"
+#include "recorder.hpp"
+#include "scenario.hpp"
+#include "shm-ring.hpp"
+#include "world.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Settings shared by all episodes of a simulator process.
+ */
+struct EpisodeOptions {
+    // Sender stamps of the UAV frames to track, one per drone.
+    std::vector<uint32_t> droneStamps{0};
+    // Advance on steps instead of wall clock.
+    bool isLockstep{false};
+    // Steps are released once every drone sent a frame, otherwise by StepRequest messages.
+    bool isStepOnFrame{false};
+    // Publish the outputs of a tick as one datagram instead of one per envelope.
+    bool isSingleDatagram{false};
+    // Additionally exchange envelopes over the shared memory rings ball-sim-<cid>-in/-out.
+    bool isSharedMemory{false};
+    // Decode only the newest frame, preview point and complete flag per sender
+    // of every receive batch; ignored in lockstep mode, where frames release steps.
+    bool isCoalescing{false};
+    // Record every sent and received envelope to this .rec file if set.
+    std::string recFile{};
+    // Neither send nor receive on the network; inputs come from receive().
+    bool isOffline{false};
+    // Simulated seconds per tick.
+    float dt{0.1f};
+    // Future ball poses published per tick as LocalPath, 0 for none.
+    uint32_t lookAhead{0};
+    // Publish the positions of all targets and balls as one packed EntityStates
+    // per tick instead of one Frame per entity.
+    bool isBulk{false};
+    // Targets are published when they move and all of them every that many
+    // simulated milliseconds for late joiners; 0 publishes them every tick.
+    uint32_t keyframePeriod{1000};
+    // Print and publish the latency histograms every that many seconds, 0 only at shutdown.
+    uint32_t latencyReportPeriod{0};
+};
+
+/**
+ * One independent ball simulation: its own OD4 session and UAV poses around
+ * a World. Several episodes can be hosted in one process.
+ */
+class Episode {
+   private:
+    Episode(const Episode &) = delete;
+    Episode(Episode &&)      = delete;
+    Episode &operator=(const Episode &) = delete;
+    Episode &operator=(Episode &&) = delete;
+
+   public:
+    /**
+     * @param cid OD4 session to communicate in.
+     * @param scenario Map to simulate; must outlive the episode.
+     * @param options Drones, stepping and publishing; see EpisodeOptions.
+     * @param onStep Called from the receive thread whenever a step was released.
+     */
+    Episode(uint16_t cid, const Scenario &scenario, const EpisodeOptions &options, std::function<void(Episode &)> onStep) noexcept;
+    ~Episode();
+
+   public:
+    bool isRunning() noexcept;
+    uint16_t cid() const noexcept;
+    LockstepTrigger &lockstep() noexcept;
+    const EpisodeMetrics &metrics() const noexcept;
+    QueueDepths queueDepths() const noexcept;
+
+    /**
+     * Whether a tracked drone sent a frame or anyone a SystemOperationState
+     * (start message) yet; drains the socket first in coalescing mode.
+     */
+    bool isReady() noexcept;
+
+    /**
+     * Publishes the SystemOperationState that tells the UAV side the episode
+     * starts ticking, either because it is ready or because the wait timed out.
+     */
+    void announceStart() noexcept;
+
+    /**
+     * Handles an envelope as if it had been received from the network: it is
+     * dropped unless it passes the receive filter.
+     */
+    void receive(cluon::data::Envelope &&envelope) noexcept;
+
+    /**
+     * Registers a consumer of every serialized envelope the episode publishes.
+     */
+    void addOutputSink(std::function<void(const char *, std::size_t)> sink) noexcept;
+
+    /**
+     * Prints the latency histograms and the lockstep and recorder statistics, if any.
+     */
+    void printStatistics(std::ostream &out) noexcept;
+
+    /**
+     * Runs one simulation tick covering the given number of tick periods, so
+     * ticks skipped by the scheduler are integrated instead of lost.
+     */
+    void tick(uint32_t periods = 1) noexcept;
+
+    /**
+     * Runs one tick per step released so far in lockstep mode.
+     */
+    void runPendingSteps() noexcept;
+
+   private:
+    void dispatch(cluon::data::Envelope &&envelope) noexcept;
+    void receiveFromSharedMemory() noexcept;
+    // Newest envelope of a coalesced subscription so far, data is null if none.
+    struct LatestEnvelope {
+        const char *data;
+        std::size_t size;
+        cluon::data::TimeStamp received;
+        // Copy of the envelope if it has to outlive the receiver's batch; keeps its capacity.
+        std::vector<char> copy;
+    };
+    // With isCopied, the newest envelopes are kept across batches until dispatchLatest();
+    // otherwise they are dispatched at the end of the batch.
+    void receiveDatagrams(const BatchReceiver::Datagram *datagrams, std::size_t count, std::vector<LatestEnvelope> &latest, bool isCopied) noexcept;
+    void dispatchLatest(std::vector<LatestEnvelope> &latest) noexcept;
+    // Coalescing mode: drains the socket and decodes each coalesced subscription once.
+    void drainReceiver() noexcept;
+    void decodeAndDispatch(const char *data, std::size_t size, const cluon::data::TimeStamp &received) noexcept;
+    // Counts an envelope the filter rejected as from an unknown sender or as filtered.
+    void countRejected(int32_t dataType) noexcept;
+    // Lockstep: queues the current inputs for count steps, then releases them.
+    void release(uint32_t count) noexcept;
+    void sampleInputs(Inputs &inputs, std::vector<int64_t> &poseReceived) noexcept;
+    // Steps with m_inputs and m_poseReceived.
+    void advance(float dt) noexcept;
+    void reportBallAlert(const BallAlertEvent &event) noexcept;
+    std::string latencyReport() const noexcept;
+
+   private:
+    uint16_t const m_cid;
+    const Scenario &m_scenario;
+    std::function<void(Episode &)> m_onStep;
+    LockstepTrigger m_lockstep{};
+    EpisodeMetrics m_metrics{};
+    std::mutex m_tickMutex{};
+
+    PoseTable m_poses;
+    // Drones that sent a frame since the last step; only touched by the receive thread.
+    std::vector<uint8_t> m_hasFrame{};
+    uint32_t m_nFramesSinceStep{0};
+    // Latest values handed over by the receive thread without locking.
+    std::atomic<float> m_dist_obs{-1.0f};
+    std::atomic<bool> m_taskCompleted{false};
+    std::atomic<bool> m_isReady{false};
+
+    World m_world;
+    Inputs m_inputs{};
+    // Lockstep: the inputs as they were when a receive handler released steps,
+    // so that a step does not see inputs that arrived before a worker ran it.
+    struct ReleasedSteps {
+        Inputs inputs;
+        std::vector<int64_t> poseReceived;
+        uint32_t count;
+    };
+    BoundedQueue<ReleasedSteps> m_releasedSteps;
+    // Steps left of the release in m_inputs; only touched by runPendingSteps().
+    uint32_t m_stepsOfRelease{0};
+    float const m_dt;
+    // Delta publishing of the targets: simulated seconds since the last keyframe,
+    // moves not yet published and the size of each target's last envelope.
+    double const m_keyframePeriod;
+    double m_sinceKeyframe;
+    std::vector<uint8_t> m_isTargetPending{};
+    std::vector<std::size_t> m_targetEnvelopeSizes{};
+    bool const m_isBulk;
+    // EntityStates data of all targets and balls; reused every tick.
+    std::string m_entityData{};
+    // LocalPath data of one ball, x, y, z floats per pose; reused every tick.
+    std::string m_lookAheadData{};
+    // Wall clock start of every close ball alert (drone * nBalls + ball).
+    std::vector<std::chrono::system_clock::time_point> m_closeBallStartTimes{};
+
+    // Per tick and drone: age of the pose at the start of the tick and at the end of
+    // the flush; per tick: time in step() and in publishing. Pose ages are not
+    // recorded offline, where the received times come from a recording.
+    std::vector<int64_t> m_poseReceived{};
+    LatencyHistogram m_poseAge{};
+    LatencyHistogram m_poseToPublish{};
+    LatencyHistogram m_decisionTime{};
+    LatencyHistogram m_sendTime{};
+    std::chrono::seconds const m_latencyReportPeriod;
+    std::chrono::steady_clock::time_point m_nextLatencyReport{};
+    bool const m_isOffline;
+
+    std::mutex m_receiveMutex{};
+    std::unordered_map<int32_t, std::function<void(cluon::data::Envelope &&)>> m_handlers{};
+    // What the handlers subscribed to; everything else is dropped before decoding.
+    EnvelopeFilter m_filter{};
+    // Per subscription of m_filter, one set per receive thread.
+    std::vector<LatestEnvelope> m_udpLatest{};
+    std::vector<LatestEnvelope> m_shmLatest{};
+    std::unique_ptr<ShmRing> m_shmIn;
+    std::unique_ptr<ShmRing> m_shmOut;
+    std::atomic<bool> m_isShmReceiving{false};
+    std::thread m_shmReceiver{};
+
+    std::unique_ptr<Recorder> m_recorder;
+    BatchPublisher m_publisher;
+    bool const m_isLockstep;
+    // Coalescing mode: no receive thread, every tick drains the socket first and
+    // decodes only the newest envelope per coalesced subscription of the whole drain.
+    bool m_isDrainedOnTick{false};
+    // Declared last so that no callback runs on a partially destroyed episode.
+    std::unique_ptr<BatchReceiver> m_receiver{};
+};
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fixed-rate-scheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+FixedRateScheduler::FixedRateScheduler(float freq) noexcept
+    : m_period{static_cast<int64_t>(std::llround(1.0e9 / static_cast<double>(freq)))}
+{
+}
+
+uint32_t FixedRateScheduler::waitForNextTick() noexcept
+{
+    if ( 0 == m_nextTick ){
+        m_start = std::chrono::steady_clock::now();
+        m_nextTick = 1;
+    }
+
+    auto deadline = m_start + m_period * m_nextTick;
+    auto now = std::chrono::steady_clock::now();
+
+    // The previous tick did not finish before this deadline.
+    int64_t missed{0};
+    if ( now > deadline ){
+        m_overruns.store(m_overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        missed = (now - deadline) / m_period;
+        m_nextTick += missed;
+        m_skippedTicks.store(m_skippedTicks.load(std::memory_order_relaxed) + static_cast<uint64_t>(missed), std::memory_order_relaxed);
+        deadline = m_start + m_period * m_nextTick;
+    }
+
+    std::this_thread::sleep_until(deadline);
+
+    const std::chrono::duration<double, std::micro> lateness = std::chrono::steady_clock::now() - deadline;
+    addJitterSample(lateness.count());
+
+    m_nextTick += 1;
+    m_ticks.store(m_ticks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return static_cast<uint32_t>(1 + missed);
+}
+
+std::chrono::nanoseconds FixedRateScheduler::period() const noexcept
+{
+    return m_period;
+}
+
+uint64_t FixedRateScheduler::ticks() const noexcept
+{
+    return m_ticks.load(std::memory_order_relaxed);
+}
+
+uint64_t FixedRateScheduler::overruns() const noexcept
+{
+    return m_overruns.load(std::memory_order_relaxed);
+}
+
+uint64_t FixedRateScheduler::skippedTicks() const noexcept
+{
+    return m_skippedTicks.load(std::memory_order_relaxed);
+}
+
+void FixedRateScheduler::printStatistics(std::ostream &out) const noexcept
+{
+    uint64_t const nTicks = ticks();
+    const double stddev = (nTicks > 1) ? std::sqrt(m_jitterM2 / static_cast<double>(nTicks - 1)) : 0.0;
+    const std::chrono::duration<double, std::milli> period = m_period;
+    out << " Scheduler: period " << period.count() << " ms"
+        << ", ticks " << nTicks
+        << ", overruns " << overruns()
+        << ", skipped " << skippedTicks()
+        << ", jitter [us] min " << m_jitterMin
+        << " mean " << m_jitterMean
+        << " max " << m_jitterMax
+        << " stddev " << stddev << std::endl;
+}
+
+void FixedRateScheduler::addJitterSample(double jitterInMicroseconds) noexcept
+{
+    uint64_t const nTicks = ticks();
+    if ( 0 == nTicks ){
+        m_jitterMin = jitterInMicroseconds;
+        m_jitterMax = jitterInMicroseconds;
+    }
+    else{
+        m_jitterMin = std::min(m_jitterMin, jitterInMicroseconds);
+        m_jitterMax = std::max(m_jitterMax, jitterInMicroseconds);
+    }
+    const double delta = jitterInMicroseconds - m_jitterMean;
+    m_jitterMean += delta / static_cast<double>(nTicks + 1);
+    m_jitterM2 += delta * (jitterInMicroseconds - m_jitterMean);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FIXED_RATE_SCHEDULER_HPP
+#define FIXED_RATE_SCHEDULER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * Deadline based scheduler: tick k is released at start + k * period, so the
+ * time spent in the loop body does not accumulate into the tick period.
+ * Ticks whose deadline already passed by more than one period are skipped
+ * and counted as overruns instead of being released in a burst. The counters
+ * can be read from any thread.
+ */
+class FixedRateScheduler {
+   private:
+    FixedRateScheduler(const FixedRateScheduler &) = delete;
+    FixedRateScheduler(FixedRateScheduler &&)      = delete;
+    FixedRateScheduler &operator=(const FixedRateScheduler &) = delete;
+    FixedRateScheduler &operator=(FixedRateScheduler &&) = delete;
+
+   public:
+    explicit FixedRateScheduler(float freq) noexcept;
+    ~FixedRateScheduler() = default;
+
+   public:
+    /**
+     * Blocks until the deadline of the next tick.
+     *
+     * @return Number of ticks released by this call (1 + skipped ticks).
+     */
+    uint32_t waitForNextTick() noexcept;
+
+    std::chrono::nanoseconds period() const noexcept;
+    uint64_t ticks() const noexcept;
+    uint64_t overruns() const noexcept;
+    uint64_t skippedTicks() const noexcept;
+    void printStatistics(std::ostream &out) const noexcept;
+
+   private:
+    void addJitterSample(double jitterInMicroseconds) noexcept;
+
+   private:
+    std::chrono::nanoseconds m_period;
+    std::chrono::steady_clock::time_point m_start{};
+    int64_t m_nextTick{0};
+
+    std::atomic<uint64_t> m_ticks{0};
+    std::atomic<uint64_t> m_overruns{0};
+    std::atomic<uint64_t> m_skippedTicks{0};
+
+    // Running statistics (Welford) of the wake-up lateness in microseconds.
+    double m_jitterMean{0.0};
+    double m_jitterM2{0.0};
+    double m_jitterMin{0.0};
+    double m_jitterMax{0.0};
+};
+
+#endif
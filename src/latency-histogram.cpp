@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "latency-histogram.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+constexpr uint32_t LatencyHistogram::SUB_BUCKET_BITS;
+constexpr uint32_t LatencyHistogram::SUB_BUCKETS;
+constexpr uint32_t LatencyHistogram::BUCKETS;
+
+LatencyHistogram::LatencyHistogram() noexcept
+{
+    for (auto &count : m_counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint32_t LatencyHistogram::bucketOf(uint64_t value) noexcept
+{
+    // Values below 2 * SUB_BUCKETS map to themselves; above, the bucket is
+    // the position of the leading bit plus the SUB_BUCKET_BITS bits after it.
+    if ( value < 2 * SUB_BUCKETS ){
+        return static_cast<uint32_t>(value);
+    }
+    uint32_t const shift = static_cast<uint32_t>(63 - __builtin_clzll(value)) - SUB_BUCKET_BITS;
+    return SUB_BUCKETS * shift + static_cast<uint32_t>(value >> shift);
+}
+
+uint64_t LatencyHistogram::upperBoundOf(uint32_t bucket) noexcept
+{
+    if ( bucket < 2 * SUB_BUCKETS ){
+        return bucket;
+    }
+    uint32_t const shift = bucket / SUB_BUCKETS - 1;
+    uint64_t const mantissa = bucket - SUB_BUCKETS * shift;
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(int64_t nanoseconds) noexcept
+{
+    int64_t const value = (nanoseconds > 0) ? nanoseconds : 0;
+    m_counts[bucketOf(static_cast<uint64_t>(value))].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    int64_t previous = m_max.load(std::memory_order_relaxed);
+    while (value > previous && !m_max.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {}
+}
+
+uint64_t LatencyHistogram::count() const noexcept
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::max() const noexcept
+{
+    return m_max.load(std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::percentile(double quantile) const noexcept
+{
+    // Buckets keep changing while we read; rank against what we actually saw.
+    uint64_t total{0};
+    for (auto const &count : m_counts) {
+        total += count.load(std::memory_order_relaxed);
+    }
+    if ( 0 == total ){
+        return 0;
+    }
+    uint64_t const rank = static_cast<uint64_t>(quantile * static_cast<double>(total - 1)) + 1;
+    uint64_t seen{0};
+    for (uint32_t bucket = 0; bucket < BUCKETS; bucket++) {
+        seen += m_counts[bucket].load(std::memory_order_relaxed);
+        if ( seen >= rank ){
+            int64_t const upperBound = static_cast<int64_t>(upperBoundOf(bucket));
+            return (upperBound < max()) ? upperBound : max();
+        }
+    }
+    return max();
+}
+
+std::string LatencyHistogram::summary() const noexcept
+{
+    std::stringstream sstr;
+    sstr << std::fixed << std::setprecision(1)
+         << "p50 " << static_cast<double>(percentile(0.5)) / 1000.0
+         << " p99 " << static_cast<double>(percentile(0.99)) / 1000.0
+         << " max " << static_cast<double>(max()) / 1000.0
+         << " us (" << count() << ")";
+    return sstr.str();
+}
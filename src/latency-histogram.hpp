@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * Log-linear histogram of durations in nanoseconds in the style of an
+ * HdrHistogram: exact below 64 ns, above that 32 buckets per power of two
+ * (about 3% resolution) up to the full int64 range. Counters are relaxed
+ * atomics, so the tick thread records without locking while any other
+ * thread reads percentiles.
+ */
+class LatencyHistogram {
+   private:
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram(LatencyHistogram &&)      = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(LatencyHistogram &&) = delete;
+
+   public:
+    LatencyHistogram() noexcept;
+    ~LatencyHistogram() = default;
+
+   public:
+    /**
+     * Adds one sample; negative durations count as 0.
+     */
+    void record(int64_t nanoseconds) noexcept;
+
+    uint64_t count() const noexcept;
+    int64_t max() const noexcept;
+
+    /**
+     * @return Upper bound of the bucket holding the given quantile (0..1), at most max().
+     */
+    int64_t percentile(double quantile) const noexcept;
+
+    /**
+     * @return "p50 <t> p99 <t> max <t> us (<count>)" with times in microseconds.
+     */
+    std::string summary() const noexcept;
+
+   private:
+    static constexpr uint32_t SUB_BUCKET_BITS{5};
+    static constexpr uint32_t SUB_BUCKETS{1 << SUB_BUCKET_BITS};
+    static constexpr uint32_t BUCKETS{(64 - SUB_BUCKET_BITS) * SUB_BUCKETS};
+
+    static uint32_t bucketOf(uint64_t value) noexcept;
+    static uint64_t upperBoundOf(uint32_t bucket) noexcept;
+
+   private:
+    std::atomic<uint64_t> m_counts[BUCKETS];
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<int64_t> m_max{0};
+};
+
+#endif
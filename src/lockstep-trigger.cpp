@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lockstep-trigger.hpp"
+
+#include <algorithm>
+
+void LockstepTrigger::step(uint32_t count) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lck(m_stepMutex);
+        m_pendingSteps += count;
+        m_requestedSteps += count;
+        m_maxPendingSteps = std::max(m_maxPendingSteps, m_pendingSteps);
+    }
+    m_stepCondition.notify_one();
+}
+
+bool LockstepTrigger::waitForStep(std::chrono::milliseconds timeout) noexcept
+{
+    std::unique_lock<std::mutex> lck(m_stepMutex);
+    if ( !m_stepCondition.wait_for(lck, timeout, [this](){ return m_pendingSteps > 0; }) ){
+        return false;
+    }
+    m_pendingSteps -= 1;
+    m_ticks += 1;
+    return true;
+}
+
+uint64_t LockstepTrigger::ticks() const noexcept
+{
+    std::lock_guard<std::mutex> lck(m_stepMutex);
+    return m_ticks;
+}
+
+uint64_t LockstepTrigger::pendingSteps() const noexcept
+{
+    std::lock_guard<std::mutex> lck(m_stepMutex);
+    return m_pendingSteps;
+}
+
+void LockstepTrigger::printStatistics(std::ostream &out) const noexcept
+{
+    std::lock_guard<std::mutex> lck(m_stepMutex);
+    out << " Lockstep: ticks " << m_ticks
+        << ", requested " << m_requestedSteps
+        << ", max pending " << m_maxPendingSteps << std::endl;
+}
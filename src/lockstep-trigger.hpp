@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOCKSTEP_TRIGGER_HPP
+#define LOCKSTEP_TRIGGER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+
+/**
+ * Releases simulation ticks on demand instead of by wall clock: receive
+ * callbacks add steps, the simulation loop consumes them one at a time.
+ */
+class LockstepTrigger {
+   private:
+    LockstepTrigger(const LockstepTrigger &) = delete;
+    LockstepTrigger(LockstepTrigger &&)      = delete;
+    LockstepTrigger &operator=(const LockstepTrigger &) = delete;
+    LockstepTrigger &operator=(LockstepTrigger &&) = delete;
+
+   public:
+    LockstepTrigger() = default;
+    ~LockstepTrigger() = default;
+
+   public:
+    void step(uint32_t count = 1) noexcept;
+
+    /**
+     * Blocks until a step is available or the timeout expired.
+     *
+     * @return true if a step was consumed.
+     */
+    bool waitForStep(std::chrono::milliseconds timeout) noexcept;
+
+    uint64_t ticks() const noexcept;
+    uint64_t pendingSteps() const noexcept;
+    void printStatistics(std::ostream &out) const noexcept;
+
+   private:
+    mutable std::mutex m_stepMutex{};
+    std::condition_variable m_stepCondition{};
+    uint64_t m_pendingSteps{0};
+    uint64_t m_requestedSteps{0};
+    uint64_t m_ticks{0};
+    uint64_t m_maxPendingSteps{0};
+};
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics-server.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+namespace {
+// How often the server thread checks for shutdown.
+constexpr int32_t POLL_TIMEOUT_MS{20};
+// A scraper that does not send its request within this time is dropped.
+constexpr int32_t REQUEST_TIMEOUT_MS{1000};
+// Requests are only read up to their headers; longer ones are cut off.
+constexpr std::size_t MAX_REQUEST_SIZE{8192};
+}
+
+MetricsServer::MetricsServer(const std::string &address, uint16_t port, std::function<std::string()> render) noexcept
+    : m_render{std::move(render)}
+{
+    struct sockaddr_in listenAddress;
+    std::memset(&listenAddress, 0, sizeof(listenAddress));
+    listenAddress.sin_family = AF_INET;
+    listenAddress.sin_port = htons(port);
+    if ( 1 != ::inet_pton(AF_INET, address.c_str(), &listenAddress.sin_addr) ){
+        std::cerr << "[MetricsServer] Invalid address " << address << std::endl;
+        return;
+    }
+
+    m_socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if ( m_socket < 0 ){
+        std::cerr << "[MetricsServer] Error while creating socket: " << std::strerror(errno) << std::endl;
+        return;
+    }
+    int32_t const YES{1};
+    if ( 0 != ::setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &YES, sizeof(YES))
+        || 0 != ::bind(m_socket, reinterpret_cast<struct sockaddr *>(&listenAddress), sizeof(listenAddress))
+        || 0 != ::listen(m_socket, 16) ){
+        std::cerr << "[MetricsServer] Could not listen on " << address << ":" << port << ": " << std::strerror(errno) << std::endl;
+        ::close(m_socket);
+        m_socket = -1;
+        return;
+    }
+
+    m_isRunning.store(true);
+    m_server = std::thread(&MetricsServer::serve, this);
+}
+
+MetricsServer::~MetricsServer() noexcept
+{
+    m_isRunning.store(false);
+    if ( m_server.joinable() ){
+        m_server.join();
+    }
+    if ( !(m_socket < 0) ){
+        ::close(m_socket);
+    }
+}
+
+bool MetricsServer::isRunning() const noexcept
+{
+    return m_isRunning.load();
+}
+
+void MetricsServer::serve() noexcept
+{
+    struct pollfd fd{m_socket, POLLIN, 0};
+    while (m_isRunning.load()) {
+        if ( 0 < ::poll(&fd, 1, POLL_TIMEOUT_MS) ){
+            int32_t const connection = ::accept(m_socket, nullptr, nullptr);
+            if ( !(connection < 0) ){
+                respond(connection);
+                ::close(connection);
+            }
+        }
+    }
+}
+
+void MetricsServer::respond(int32_t connection) noexcept
+{
+    struct timeval timeout{REQUEST_TIMEOUT_MS / 1000, (REQUEST_TIMEOUT_MS % 1000) * 1000};
+    ::setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Everything up to the end of the headers; the request line is all we look at.
+    std::string request;
+    char buffer[1024];
+    while (std::string::npos == request.find("\r\n\r\n") && request.size() < MAX_REQUEST_SIZE) {
+        ssize_t const n = ::recv(connection, buffer, sizeof(buffer), 0);
+        if ( n <= 0 ){
+            break;
+        }
+        request.append(buffer, static_cast<std::size_t>(n));
+    }
+    if ( request.empty() ){
+        return;
+    }
+
+    std::string response;
+    if ( 0 == request.compare(0, 4, "GET ") ){
+        std::string const body{m_render()};
+        response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: "
+            + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+    }
+    else{
+        response = "HTTP/1.1 405 Method Not Allowed\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    }
+    std::size_t sent{0};
+    while (sent < response.size()) {
+        ssize_t const n = ::send(connection, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if ( n <= 0 ){
+            break;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef METRICS_SERVER_HPP
+#define METRICS_SERVER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+/**
+ * Minimal HTTP endpoint for Prometheus: answers every GET request on
+ * address:port with the text returned by render, which runs on the server's
+ * thread and must only read relaxed atomics or take short locks. Scrapes are
+ * served one at a time and every connection is closed after its response.
+ */
+class MetricsServer {
+   private:
+    MetricsServer(const MetricsServer &) = delete;
+    MetricsServer(MetricsServer &&)      = delete;
+    MetricsServer &operator=(const MetricsServer &) = delete;
+    MetricsServer &operator=(MetricsServer &&) = delete;
+
+   public:
+    /**
+     * @param address Numerical IPv4 address to listen on, e.g. 127.0.0.1 or 0.0.0.0 for all interfaces.
+     */
+    MetricsServer(const std::string &address, uint16_t port, std::function<std::string()> render) noexcept;
+    ~MetricsServer() noexcept;
+
+   public:
+    bool isRunning() const noexcept;
+
+   private:
+    void serve() noexcept;
+    void respond(int32_t connection) noexcept;
+
+   private:
+    std::function<std::string()> m_render;
+    int32_t m_socket{-1};
+    std::atomic<bool> m_isRunning{false};
+    std::thread m_server{};
+};
+
+#endif
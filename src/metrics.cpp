@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "metrics.hpp"
+#include "ball-simulator-messages.hpp"
+#include "opendlv-standard-message-set.hpp"
+
+EpisodeMetrics::MessageType EpisodeMetrics::messageTypeOf(int32_t dataType) noexcept
+{
+    static const int32_t IDS[OTHER]{
+        opendlv::sim::Frame::ID(),
+        opendlv::sim::KinematicState::ID(),
+        opendlv::logic::action::LocalPath::ID(),
+        opendlv::sim::EntityStates::ID(),
+        opendlv::logic::sensation::TargetFoundState::ID(),
+        opendlv::logic::action::PreviewPoint::ID(),
+        opendlv::logic::sensation::CompleteFlag::ID(),
+        opendlv::sim::StepRequest::ID(),
+        opendlv::system::LogMessage::ID(),
+        opendlv::system::SystemOperationState::ID()};
+    for (uint32_t i = 0; i < OTHER; i++) {
+        if ( IDS[i] == dataType ){
+            return static_cast<MessageType>(i);
+        }
+    }
+    return OTHER;
+}
+
+const char *EpisodeMetrics::nameOf(uint32_t messageType) noexcept
+{
+    static const char *const NAMES[MESSAGE_TYPES + 1]{
+        "opendlv.sim.Frame",
+        "opendlv.sim.KinematicState",
+        "opendlv.logic.action.LocalPath",
+        "opendlv.sim.EntityStates",
+        "opendlv.logic.sensation.TargetFoundState",
+        "opendlv.logic.action.PreviewPoint",
+        "opendlv.logic.sensation.CompleteFlag",
+        "opendlv.sim.StepRequest",
+        "opendlv.system.LogMessage",
+        "opendlv.system.SystemOperationState",
+        "other",
+        ""};
+    return NAMES[(messageType < MESSAGE_TYPES) ? messageType : MESSAGE_TYPES];
+}
+
+EpisodeMetrics::EpisodeMetrics() noexcept
+{
+    for (uint32_t i = 0; i < MESSAGE_TYPES; i++) {
+        received[i].store(0, std::memory_order_relaxed);
+        sent[i].store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Counters of one episode for the metrics endpoint. Every counter has one
+ * writer at a time (the tick or the receive lock is held), so increments are
+ * a relaxed load and store instead of a locked read-modify-write; readers on
+ * other threads may see a value that is a few updates old.
+ */
+struct EpisodeMetrics {
+    // Message types counted separately; everything else is OTHER.
+    enum MessageType : uint32_t {
+        FRAME,
+        KINEMATIC_STATE,
+        LOCAL_PATH,
+        ENTITY_STATES,
+        TARGET_FOUND_STATE,
+        PREVIEW_POINT,
+        COMPLETE_FLAG,
+        STEP_REQUEST,
+        LOG_MESSAGE,
+        SYSTEM_OPERATION_STATE,
+        OTHER,
+        MESSAGE_TYPES
+    };
+
+    static MessageType messageTypeOf(int32_t dataType) noexcept;
+    static const char *nameOf(uint32_t messageType) noexcept;
+
+    EpisodeMetrics() noexcept;
+
+    std::atomic<uint64_t> ticks{0};
+    std::atomic<uint64_t> captures{0};
+    std::atomic<uint64_t> ballAlerts{0};
+    // Messages of a handled type from a sender stamp that is not tracked, and
+    // envelopes of a type nothing subscribed to; both are dropped by the
+    // receive filter before decoding. Written by the UDP and the shared memory
+    // receiver, so they are real atomic increments.
+    std::atomic<uint64_t> unknownSenders{0};
+    std::atomic<uint64_t> filtered{0};
+    // Messages of a type without handler.
+    std::atomic<uint64_t> unhandledTypes{0};
+    // Envelopes superseded by a newer one of the same type and sender in the same per-tick drain.
+    std::atomic<uint64_t> coalesced{0};
+    // Target frames not republished because the target did not move, and their bytes.
+    std::atomic<uint64_t> deltaSkipped{0};
+    std::atomic<uint64_t> deltaSavedBytes{0};
+    std::atomic<uint64_t> received[MESSAGE_TYPES];
+    std::atomic<uint64_t> sent[MESSAGE_TYPES];
+};
+
+/**
+ * Adds to a counter that only the calling thread writes.
+ */
+inline void increment(std::atomic<uint64_t> &counter, uint64_t count = 1) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+}
+
+/**
+ * Backlogs and drops between an episode and its transports, sampled when scraped.
+ */
+struct QueueDepths {
+    uint64_t pendingSteps;
+    uint64_t recorderBacklog;
+    uint64_t recorderDropped;
+    uint64_t shmDropped;
+    // recvmmsg calls of the UDP receiver and datagrams it dropped as too long.
+    uint64_t receiveBatches;
+    uint64_t receiveTruncated;
+    // Datagrams the publisher failed to send.
+    uint64_t sendErrors;
+};
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pose-table.hpp"
+
+#include <algorithm>
+
+PoseTable::PoseTable(const std::vector<uint32_t> &senderStamps) noexcept
+    : m_senderStamps{senderStamps}
+    , m_slots{new Seqlock<Pose>[senderStamps.size()]}
+{
+}
+
+int32_t PoseTable::indexOf(uint32_t senderStamp) const noexcept
+{
+    // Swarms are small; a linear scan beats hashing here.
+    auto it = std::find(m_senderStamps.begin(), m_senderStamps.end(), senderStamp);
+    return (it == m_senderStamps.end()) ? -1 : static_cast<int32_t>(it - m_senderStamps.begin());
+}
+
+void PoseTable::update(uint32_t index, const Pose &pose) noexcept
+{
+    m_slots[index].store(pose);
+}
+
+PoseTable::Pose PoseTable::pose(uint32_t index) const noexcept
+{
+    return m_slots[index].load();
+}
+
+uint32_t PoseTable::senderStamp(uint32_t index) const noexcept
+{
+    return m_senderStamps[index];
+}
+
+uint32_t PoseTable::size() const noexcept
+{
+    return static_cast<uint32_t>(m_senderStamps.size());
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POSE_TABLE_HPP
+#define POSE_TABLE_HPP
+
+#include "seqlock.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Latest pose of every tracked UAV, keyed by the sender stamp of its
+ * opendlv.sim.Frame. Each drone has its own seqlocked slot: the receive
+ * thread never waits for the simulation loop, and the loop always reads a
+ * consistent pose.
+ */
+class PoseTable {
+   private:
+    PoseTable(const PoseTable &) = delete;
+    PoseTable(PoseTable &&)      = delete;
+    PoseTable &operator=(const PoseTable &) = delete;
+    PoseTable &operator=(PoseTable &&) = delete;
+
+   public:
+    struct Pose {
+        float x;
+        float y;
+        // Sample time of the frame in microseconds.
+        int64_t timestamp;
+        // When the frame arrived in microseconds since the epoch, 0 before the first one.
+        int64_t received;
+    };
+
+   public:
+    explicit PoseTable(const std::vector<uint32_t> &senderStamps) noexcept;
+    ~PoseTable() = default;
+
+   public:
+    /**
+     * @return Slot of the drone with the given sender stamp, or -1 if it is not tracked.
+     */
+    int32_t indexOf(uint32_t senderStamp) const noexcept;
+
+    /**
+     * Stores a new pose; all updates of one table must come from the same thread.
+     */
+    void update(uint32_t index, const Pose &pose) noexcept;
+    Pose pose(uint32_t index) const noexcept;
+    uint32_t senderStamp(uint32_t index) const noexcept;
+    uint32_t size() const noexcept;
+
+   private:
+    std::vector<uint32_t> m_senderStamps;
+    std::unique_ptr<Seqlock<Pose>[]> m_slots;
+};
+
+#endif
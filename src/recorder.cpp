@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "recorder.hpp"
+
+#include <chrono>
+
+namespace {
+// Envelopes in flight between the simulation and the writer thread.
+constexpr std::size_t QUEUE_CAPACITY{8192};
+}
+
+Recorder::Recorder(const std::string &filename) noexcept
+    : m_filename{filename}
+    , m_file{filename, std::ios::out | std::ios::binary | std::ios::trunc}
+    , m_queue{QUEUE_CAPACITY}
+{
+    if ( m_file.good() ){
+        m_writer = std::thread(&Recorder::writeLoop, this);
+    }
+}
+
+Recorder::~Recorder() noexcept
+{
+    m_isRunning.store(false);
+    if ( m_writer.joinable() ){
+        m_writer.join();
+    }
+}
+
+bool Recorder::isValid() const noexcept
+{
+    return m_writer.joinable();
+}
+
+void Recorder::record(const char *data, std::size_t size) noexcept
+{
+    // Count before pushing so that the writer can never get ahead of m_recorded.
+    m_recorded.fetch_add(1, std::memory_order_relaxed);
+    bool const isQueued = m_queue.tryPush([data, size](std::vector<char> &envelope){
+        envelope.assign(data, data + size);
+    });
+    if ( !isQueued ){
+        m_recorded.fetch_sub(1, std::memory_order_relaxed);
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+uint64_t Recorder::backlog() const noexcept
+{
+    // The counters are read separately, so clamp instead of wrapping around.
+    uint64_t const written = m_written.load(std::memory_order_relaxed);
+    uint64_t const recorded = m_recorded.load(std::memory_order_relaxed);
+    return recorded > written ? recorded - written : 0;
+}
+
+uint64_t Recorder::dropped() const noexcept
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+void Recorder::printStatistics(std::ostream &out) const noexcept
+{
+    out << " Recorder: " << m_filename << ", recorded " << m_recorded.load() << ", dropped " << m_dropped.load() << std::endl;
+}
+
+void Recorder::writeLoop() noexcept
+{
+    auto write = [this](std::vector<char> &envelope){
+        m_file.write(envelope.data(), static_cast<std::streamsize>(envelope.size()));
+        m_written.store(m_written.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    };
+    bool isRunning{true};
+    while (isRunning) {
+        // Read the flag first so that everything queued before the stop is written.
+        isRunning = m_isRunning.load();
+        uint32_t count{0};
+        while (m_queue.tryPop(write)) {
+            count += 1;
+        }
+        if ( 0 == count && isRunning ){
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    m_file.flush();
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RECORDER_HPP
+#define RECORDER_HPP
+
+#include "bounded-queue.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Writes serialized OD4 envelopes to a .rec file that cluon::Player can
+ * replay. Producers only copy into a bounded lock-free queue; a dedicated
+ * thread does the file I/O. When the queue is full, envelopes are dropped
+ * and counted instead of stalling the simulation.
+ */
+class Recorder {
+   private:
+    Recorder(const Recorder &) = delete;
+    Recorder(Recorder &&)      = delete;
+    Recorder &operator=(const Recorder &) = delete;
+    Recorder &operator=(Recorder &&) = delete;
+
+   public:
+    explicit Recorder(const std::string &filename) noexcept;
+    ~Recorder() noexcept;
+
+   public:
+    bool isValid() const noexcept;
+
+    /**
+     * Queues one serialized envelope (header included); safe from any thread.
+     */
+    void record(const char *data, std::size_t size) noexcept;
+
+    /**
+     * @return Envelopes queued but not yet written.
+     */
+    uint64_t backlog() const noexcept;
+    uint64_t dropped() const noexcept;
+    void printStatistics(std::ostream &out) const noexcept;
+
+   private:
+    void writeLoop() noexcept;
+
+   private:
+    std::string const m_filename;
+    std::ofstream m_file;
+    BoundedQueue<std::vector<char>> m_queue;
+    std::atomic<uint64_t> m_recorded{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_written{0};
+    std::atomic<bool> m_isRunning{true};
+    std::thread m_writer{};
+};
+
+#endif
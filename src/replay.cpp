@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "replay.hpp"
+#include "ball-simulator-messages.hpp"
+#include "cluon-complete.hpp"
+#include "entity-states.hpp"
+#include "opendlv-standard-message-set.hpp"
+
+#include <endian.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+// Everything published per tick, as opposed to the UAV inputs: target and ball
+// frames or EntityStates, KinematicStates, LocalPaths and TargetFoundStates.
+bool isOutput(const cluon::data::Envelope &envelope, const std::vector<uint32_t> &droneStamps)
+{
+    int32_t const dataType{envelope.dataType()};
+    if ( opendlv::logic::sensation::TargetFoundState::ID() == dataType || opendlv::sim::KinematicState::ID() == dataType
+        || opendlv::logic::action::LocalPath::ID() == dataType || opendlv::sim::EntityStates::ID() == dataType ){
+        return true;
+    }
+    return opendlv::sim::Frame::ID() == envelope.dataType()
+        && droneStamps.end() == std::find(droneStamps.begin(), droneStamps.end(), envelope.senderStamp());
+}
+
+bool isSameOutput(const cluon::data::Envelope &a, const cluon::data::Envelope &b)
+{
+    return a.dataType() == b.dataType() && a.senderStamp() == b.senderStamp() && a.serializedData() == b.serializedData();
+}
+
+// Little-endian float of LocalPath data.
+float floatAt(const std::string &data, std::size_t offset)
+{
+    uint32_t bits;
+    std::memcpy(&bits, data.data() + offset, sizeof(bits));
+    bits = le32toh(bits);
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+std::string describe(const cluon::data::Envelope &envelope)
+{
+    std::stringstream sstr;
+    if ( opendlv::sim::Frame::ID() == envelope.dataType() ){
+        auto frame = cluon::extractMessage<opendlv::sim::Frame>(cluon::data::Envelope{envelope});
+        sstr << "Frame[" << envelope.senderStamp() << "] " << frame.x() << "," << frame.y() << "," << frame.z();
+    }
+    else if ( opendlv::sim::KinematicState::ID() == envelope.dataType() ){
+        auto state = cluon::extractMessage<opendlv::sim::KinematicState>(cluon::data::Envelope{envelope});
+        sstr << "KinematicState[" << envelope.senderStamp() << "] " << state.vx() << "," << state.vy();
+    }
+    else if ( opendlv::logic::action::LocalPath::ID() == envelope.dataType() ){
+        auto path = cluon::extractMessage<opendlv::logic::action::LocalPath>(cluon::data::Envelope{envelope});
+        sstr << "LocalPath[" << envelope.senderStamp() << "] " << path.length() << " poses";
+        if ( path.data().size() >= 2 * sizeof(float) ){
+            sstr << " from " << floatAt(path.data(), 0) << "," << floatAt(path.data(), sizeof(float));
+        }
+    }
+    else if ( opendlv::sim::EntityStates::ID() == envelope.dataType() ){
+        auto entities = cluon::extractMessage<opendlv::sim::EntityStates>(cluon::data::Envelope{envelope});
+        float z;
+        std::vector<EntityState> states;
+        unpackEntityStates(entities.data(), z, states);
+        sstr << "EntityStates[" << envelope.senderStamp() << "] " << entities.count() << " entities";
+        if ( !states.empty() ){
+            sstr << ", first " << states.front().senderStamp << " at " << states.front().x << "," << states.front().y;
+        }
+    }
+    else{
+        auto state = cluon::extractMessage<opendlv::logic::sensation::TargetFoundState>(cluon::data::Envelope{envelope});
+        sstr << "TargetFoundState[" << envelope.senderStamp() << "] count " << state.target_found_count() << " chpad " << state.is_chpad_found();
+    }
+    return sstr.str();
+}
+
+bool loadOutputs(const std::string &filename, const std::vector<uint32_t> &droneStamps, std::vector<cluon::data::Envelope> &outputs)
+{
+    cluon::Player player{filename, false, false};
+    if ( !player.hasMoreData() ){
+        return false;
+    }
+    while (player.hasMoreData()) {
+        auto next = player.getNextEnvelopeToBeReplayed();
+        if ( next.first && isOutput(next.second, droneStamps) ){
+            outputs.push_back(std::move(next.second));
+        }
+    }
+    return true;
+}
+} // namespace
+
+int32_t runReplay(std::map<std::string, std::string> &commandlineArguments, const Scenario &scenario, EpisodeOptions options) noexcept
+{
+    int32_t retCode{1};
+    std::string const inputFile{commandlineArguments["replay"]};
+
+    // Steps follow the recorded UAV frames (or StepRequests with --lockstep=step) instead of the wall clock.
+    options.isOffline = true;
+    options.isSharedMemory = false;
+    options.isLockstep = true;
+    options.isStepOnFrame = ("step" != commandlineArguments["lockstep"]);
+
+    std::vector<cluon::data::Envelope> outputs;
+    Episode episode{0, scenario, options, [](Episode &e){ e.runPendingSteps(); }};
+    episode.addOutputSink([&outputs, &options](const char *data, std::size_t size){
+        std::stringstream sstr{std::string(data, size)};
+        auto retVal = cluon::extractEnvelope(sstr);
+        if ( retVal.first && isOutput(retVal.second, options.droneStamps) ){
+            outputs.push_back(std::move(retVal.second));
+        }
+    });
+
+    cluon::Player player{inputFile, false, false};
+    if ( !player.hasMoreData() ){
+        std::cerr << "You should include a non-empty .rec file to replay..." << std::endl;
+        return retCode;
+    }
+    // Outputs of the recorded run are skipped, and episode.receive() drops whatever
+    // the live receive filter would, so that only inputs are handled and recorded.
+    uint64_t nInputs{0};
+    uint64_t nSkipped{0};
+    auto const start = std::chrono::steady_clock::now();
+    while (player.hasMoreData()) {
+        auto next = player.getNextEnvelopeToBeReplayed();
+        if ( next.first ){
+            if ( isOutput(next.second, options.droneStamps) ){
+                nSkipped += 1;
+                continue;
+            }
+            nInputs += 1;
+            episode.receive(std::move(next.second));
+        }
+    }
+    std::chrono::duration<double, std::milli> const elapsed = std::chrono::steady_clock::now() - start;
+    uint64_t const nFiltered{episode.metrics().filtered.load(std::memory_order_relaxed)
+                             + episode.metrics().unknownSenders.load(std::memory_order_relaxed)};
+    std::cout << " Replay: " << nInputs - nFiltered << " inputs (" << nSkipped << " recorded outputs and " << nFiltered
+              << " unsubscribed envelopes skipped), " << episode.lockstep().ticks() << " ticks, "
+              << outputs.size() << " outputs in " << elapsed.count() << " ms" << std::endl;
+
+    retCode = 0;
+    if ( (0 != commandlineArguments.count("golden")) ) {
+        std::vector<cluon::data::Envelope> golden;
+        if ( !loadOutputs(commandlineArguments["golden"], options.droneStamps, golden) ){
+            std::cerr << "You should include a non-empty golden .rec file..." << std::endl;
+            return 1;
+        }
+
+        std::size_t const nCompared{std::min(golden.size(), outputs.size())};
+        std::size_t nDiffering{std::max(golden.size(), outputs.size()) - nCompared};
+        std::size_t firstDifference{nCompared};
+        for (std::size_t i = 0; i < nCompared; i++) {
+            if ( !isSameOutput(golden[i], outputs[i]) ){
+                nDiffering += 1;
+                firstDifference = std::min(firstDifference, i);
+            }
+        }
+
+        if ( 0 == nDiffering ){
+            std::cout << " Golden: identical, " << golden.size() << " outputs" << std::endl;
+        }
+        else{
+            std::cout << " Golden: " << nDiffering << " of " << std::max(golden.size(), outputs.size()) << " outputs differ";
+            if ( firstDifference < nCompared ){
+                std::cout << "; first at #" << firstDifference << ": expected " << describe(golden[firstDifference])
+                          << ", got " << describe(outputs[firstDifference]);
+            }
+            else{
+                std::cout << "; expected " << golden.size() << " outputs, got " << outputs.size();
+            }
+            std::cout << std::endl;
+            retCode = 1;
+        }
+    }
+    episode.printStatistics(std::cout);
+    return retCode;
+}
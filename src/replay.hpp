@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include "episode.hpp"
+#include "scenario.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * Feeds the input envelopes of a .rec file (--replay) through one offline
+ * episode as fast as possible; recorded outputs and envelopes the receive
+ * filter rejects are skipped. Steps in lockstep with the recorded UAV frames,
+ * and compares the produced target/ball frames or EntityStates,
+ * KinematicStates, LocalPaths and TargetFoundStates with those of a golden
+ * recording (--golden).
+ *
+ * @return Exit code for main(); 1 if the outputs differ from the golden recording.
+ */
+int32_t runReplay(std::map<std::string, std::string> &commandlineArguments, const Scenario &scenario, EpisodeOptions options) noexcept;
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scenario.hpp"
+#include "builtin-scenarios.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <unordered_set>
+
+namespace {
+bool readFloats(std::istringstream &tokens, float *values, uint32_t count) noexcept {
+    for (uint32_t i = 0; i < count; i++) {
+        if ( !(tokens >> values[i]) ){
+            return false;
+        }
+    }
+    return true;
+}
+
+// Balls declared without phases sweep along x forever.
+void finalizeLastBall(Scenario &scenario) noexcept {
+    if ( !scenario.balls.empty() && scenario.balls.back().firstPhase == scenario.balls.back().endPhase ){
+        scenario.phases.push_back(BallPhase{0.0f, 0.0f, 0.0f, 1.0f, 0.0f, true});
+        scenario.balls.back().endPhase = static_cast<uint32_t>(scenario.phases.size());
+    }
+}
+} // namespace
+
+bool parseScenario(std::istream &in, Scenario &scenario, std::string &error) noexcept
+{
+    uint32_t lineNumber{0};
+    // Targets and balls share the sender stamps of the published Frames.
+    std::unordered_set<uint32_t> senderStamps;
+    std::string line;
+    while (std::getline(in, line)) {
+        lineNumber += 1;
+        std::string const content{line.substr(0, line.find('#'))};
+        std::istringstream tokens{content};
+        std::string key;
+        if ( !(tokens >> key) ){
+            continue;
+        }
+
+        bool isValid{true};
+        if ( "name" == key ){
+            isValid = static_cast<bool>(tokens >> scenario.name);
+        }
+        else if ( "height" == key ){
+            isValid = readFloats(tokens, &scenario.height, 1);
+        }
+        else if ( "capture_radius" == key ){
+            isValid = readFloats(tokens, &scenario.captureRadius, 1) && scenario.captureRadius > 0.0f;
+        }
+        else if ( "hidden" == key ){
+            isValid = readFloats(tokens, &scenario.hidden.x, 1) && readFloats(tokens, &scenario.hidden.y, 1);
+        }
+        else if ( "ball_hold_distance" == key ){
+            isValid = readFloats(tokens, &scenario.ballHoldDistance, 1);
+        }
+        else if ( "ball_alert_radius" == key ){
+            isValid = readFloats(tokens, &scenario.ballAlertRadius, 1) && scenario.ballAlertRadius >= 0.0f;
+        }
+        else if ( "uav_radius" == key ){
+            isValid = readFloats(tokens, &scenario.uavRadius, 1) && scenario.uavRadius >= 0.0f;
+        }
+        else if ( "ball_radius" == key ){
+            isValid = readFloats(tokens, &scenario.ballRadius, 1) && scenario.ballRadius >= 0.0f;
+        }
+        else if ( "chpad" == key ){
+            float values[3];
+            isValid = readFloats(tokens, values, 3) && values[2] > 0.0f;
+            scenario.hasChpad = isValid;
+            scenario.chpad = Waypoint{values[0], values[1]};
+            scenario.chpadRadius = values[2];
+        }
+        else if ( "target" == key ){
+            // target <stamp> <x> <y> [<x> <y> ...]
+            TargetSpec target{0, static_cast<uint32_t>(scenario.waypoints.size()), 0};
+            isValid = static_cast<bool>(tokens >> target.senderStamp);
+            Waypoint waypoint{0.0f, 0.0f};
+            while (isValid && (tokens >> waypoint.x)) {
+                isValid = static_cast<bool>(tokens >> waypoint.y);
+                scenario.waypoints.push_back(waypoint);
+            }
+            target.endWaypoint = static_cast<uint32_t>(scenario.waypoints.size());
+            isValid = isValid && target.endWaypoint > target.firstWaypoint
+                && senderStamps.insert(target.senderStamp).second;
+            scenario.targets.push_back(target);
+        }
+        else if ( "ball" == key ){
+            // ball <stamp> <min> <max> <speed> [<start> [<acceleration>]]
+            finalizeLastBall(scenario);
+            BallSpec ball{0, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, static_cast<uint32_t>(scenario.phases.size()), static_cast<uint32_t>(scenario.phases.size())};
+            isValid = static_cast<bool>(tokens >> ball.senderStamp) && readFloats(tokens, &ball.sweepMin, 1)
+                && readFloats(tokens, &ball.sweepMax, 1) && readFloats(tokens, &ball.speed, 1);
+            if ( isValid && !readFloats(tokens, &ball.start, 1) ){
+                ball.start = 0.0f;
+            }
+            else if ( isValid && !readFloats(tokens, &ball.acceleration, 1) ){
+                ball.acceleration = 0.0f;
+            }
+            // The ball has to start on its path.
+            isValid = isValid && ball.sweepMin < ball.sweepMax && ball.speed > 0.0f
+                && ball.acceleration >= 0.0f && ball.sweepMin <= ball.start && ball.start <= ball.sweepMax
+                && senderStamps.insert(ball.senderStamp).second;
+            scenario.balls.push_back(ball);
+        }
+        else if ( "phase" == key ){
+            // phase <seconds> <ox> <oy> <dx> <dy> | phase <seconds> hidden, for the last ball
+            BallPhase phase{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, true};
+            isValid = !scenario.balls.empty() && readFloats(tokens, &phase.duration, 1) && phase.duration >= 0.0f;
+            std::string hidden;
+            std::streampos const pos{tokens.tellg()};
+            if ( isValid && (tokens >> hidden) && "hidden" == hidden ){
+                phase.isVisible = false;
+            }
+            else if ( isValid ){
+                tokens.clear();
+                tokens.seekg(pos);
+                isValid = readFloats(tokens, &phase.ox, 4);
+            }
+            if ( isValid ){
+                scenario.phases.push_back(phase);
+                scenario.balls.back().endPhase = static_cast<uint32_t>(scenario.phases.size());
+            }
+        }
+        else{
+            isValid = false;
+        }
+        // Nothing may follow the fields of any key.
+        isValid = isValid && (tokens >> std::ws).eof();
+
+        if ( !isValid ){
+            error = "line " + std::to_string(lineNumber) + ": invalid '" + key + "' entry";
+            return false;
+        }
+    }
+
+    finalizeLastBall(scenario);
+    return true;
+}
+
+bool loadScenario(const std::string &filename, Scenario &scenario, std::string &error) noexcept
+{
+    std::ifstream in(filename);
+    if ( !in.good() ){
+        error = "could not open " + filename;
+        return false;
+    }
+    return parseScenario(in, scenario, error);
+}
+
+float scenarioExtent(const Scenario &scenario) noexcept
+{
+    float extent{std::max(std::fabs(scenario.hidden.x), std::fabs(scenario.hidden.y))};
+    for (Waypoint const &waypoint : scenario.waypoints) {
+        extent = std::max(extent, std::max(std::fabs(waypoint.x), std::fabs(waypoint.y)));
+    }
+    // Phases are linear in the sweep coordinate, so the limits are the extremes.
+    for (BallSpec const &ball : scenario.balls) {
+        for (uint32_t i = ball.firstPhase; i < ball.endPhase; i++) {
+            BallPhase const &phase = scenario.phases[i];
+            for (float const s : {ball.sweepMin, ball.sweepMax}) {
+                if ( phase.isVisible ){
+                    extent = std::max(extent, std::max(std::fabs(phase.ox + s * phase.dx), std::fabs(phase.oy + s * phase.dy)));
+                }
+            }
+        }
+    }
+    return extent;
+}
+
+bool builtinScenario(const std::string &name, Scenario &scenario, std::string &error) noexcept
+{
+    for (auto const &builtin : BUILTIN_SCENARIOS) {
+        if ( name == builtin.first ){
+            std::istringstream in{builtin.second};
+            return parseScenario(in, scenario, error);
+        }
+    }
+    error = "no builtin scenario named " + name;
+    return false;
+}
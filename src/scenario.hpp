@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCENARIO_HPP
+#define SCENARIO_HPP
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+struct Waypoint {
+    float x;
+    float y;
+};
+
+/**
+ * A target is shown at its waypoints [firstWaypoint, endWaypoint) one after
+ * the other; each capture moves it to the next one until it is hidden.
+ */
+struct TargetSpec {
+    uint32_t senderStamp;
+    uint32_t firstWaypoint;
+    uint32_t endWaypoint;
+};
+
+/**
+ * Part of a ball's cycle: for 'duration' seconds (0 = forever) the ball is at
+ * origin + direction * s, where s sweeps between the ball's limits.
+ */
+struct BallPhase {
+    float duration;
+    float ox;
+    float oy;
+    float dx;
+    float dy;
+    bool isVisible;
+};
+
+/**
+ * Speed in m/s along the sweep coordinate; acceleration in m/s^2, 0 for
+ * instant reversals at the limits.
+ */
+struct BallSpec {
+    uint32_t senderStamp;
+    float sweepMin;
+    float sweepMax;
+    float speed;
+    float start;
+    float acceleration;
+    uint32_t firstPhase;
+    uint32_t endPhase;
+};
+
+/**
+ * Static description of a map, parsed once and shared by all episodes.
+ * Targets, waypoints and phases live in flat arrays indexed by the specs.
+ */
+struct Scenario {
+    std::string name{};
+    float height{1.5f};
+    float captureRadius{0.3f};
+    Waypoint hidden{-5.0f, -5.0f};
+    // The balls only move while the UAV's preview distance is above this value.
+    float ballHoldDistance{0.1f};
+    // Distance at which a "too close to the ball" event is reported, 0 to disable.
+    float ballAlertRadius{0.0f};
+    // Added to the alert radius, which then applies between the surfaces.
+    float uavRadius{0.0f};
+    float ballRadius{0.0f};
+    bool hasChpad{false};
+    Waypoint chpad{0.0f, 0.0f};
+    float chpadRadius{0.1f};
+
+    std::vector<Waypoint> waypoints{};
+    std::vector<TargetSpec> targets{};
+    std::vector<BallPhase> phases{};
+    std::vector<BallSpec> balls{};
+};
+
+/**
+ * Parses a scenario in the line based format documented in scenarios/README.md.
+ *
+ * @return true on success, otherwise error describes the offending line.
+ */
+bool parseScenario(std::istream &in, Scenario &scenario, std::string &error) noexcept;
+bool loadScenario(const std::string &filename, Scenario &scenario, std::string &error) noexcept;
+
+/**
+ * @return Largest absolute x or y at which a target or ball of the scenario
+ * is published: waypoints, the hidden position and the sweep limits of
+ * every visible ball phase.
+ */
+float scenarioExtent(const Scenario &scenario) noexcept;
+
+/**
+ * Scenarios compiled into the binary from the scenarios directory, e.g. "rooms".
+ */
+bool builtinScenario(const std::string &name, Scenario &scenario, std::string &error) noexcept;
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Latest-value handoff from one writer thread to any number of readers.
+ * The writer never blocks; a reader retries while a write is in progress
+ * and always returns a value that was stored as a whole. The payload is
+ * kept in relaxed atomic words, so concurrent access is free of data races.
+ */
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock requires a trivially copyable type");
+
+   private:
+    Seqlock(const Seqlock &) = delete;
+    Seqlock(Seqlock &&)      = delete;
+    Seqlock &operator=(const Seqlock &) = delete;
+    Seqlock &operator=(Seqlock &&) = delete;
+
+   public:
+    explicit Seqlock(const T &value = T{}) noexcept
+    {
+        store(value);
+    }
+    ~Seqlock() = default;
+
+   public:
+    /**
+     * Publishes a new value; must only be called from a single thread.
+     */
+    void store(const T &value) noexcept
+    {
+        uint64_t words[WORDS]{};
+        std::memcpy(words, &value, sizeof(T));
+
+        uint32_t const sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < WORDS; i++) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    T load() const noexcept
+    {
+        uint64_t words[WORDS];
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = m_sequence.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < WORDS; i++) {
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_sequence.load(std::memory_order_relaxed);
+        } while ( (before & 1) != 0 || before != after );
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+   private:
+    static constexpr std::size_t WORDS{(sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t)};
+
+    // Odd while a write is in progress.
+    std::atomic<uint32_t> m_sequence{0};
+    std::atomic<uint64_t> m_words[WORDS];
+};
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shm-ring.hpp"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <new>
+#include <thread>
+
+namespace {
+constexpr uint32_t RING_MAGIC{0xBA11517u};
+// Set in the length word of every written record; a zero length word is not written yet.
+constexpr uint32_t COMMITTED{0x80000000u};
+// Record length that tells the consumer to continue at the start of the ring.
+constexpr uint32_t WRAP_MARKER{0xFFFFFFFFu};
+constexpr std::size_t ALIGNMENT{64};
+// Time an idle consumer keeps polling before it sleeps.
+constexpr std::chrono::microseconds SPIN_TIME{20};
+
+inline std::size_t recordSize(std::size_t size) noexcept
+{
+    return (sizeof(uint32_t) + size + 7) & ~static_cast<std::size_t>(7);
+}
+
+// Length words are shared with other processes; records are 8 byte aligned.
+inline uint32_t loadLength(const char *record) noexcept
+{
+    return __atomic_load_n(reinterpret_cast<const uint32_t *>(record), __ATOMIC_ACQUIRE);
+}
+
+inline void storeLength(char *record, uint32_t length) noexcept
+{
+    __atomic_store_n(reinterpret_cast<uint32_t *>(record), length, __ATOMIC_RELEASE);
+}
+}
+
+struct ShmRing::Header {
+    uint32_t magic;
+    uint32_t capacity;
+    // Bytes reserved by producers so far, advanced by compare and swap.
+    alignas(64) std::atomic<uint64_t> reserved;
+    // Futex word: bumped on every push while the consumer sleeps.
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> isConsumerSleeping;
+    // Bytes consumed so far, advanced by the consumer only.
+    alignas(64) std::atomic<uint64_t> tail;
+};
+
+ShmRing::ShmRing(const std::string &name, uint32_t capacity) noexcept
+{
+    uint32_t const size{(0 == capacity) ? 0 : static_cast<uint32_t>(ALIGNMENT + sizeof(Header) + ((capacity + 7) & ~7u))};
+    m_sharedMemory.reset(new cluon::SharedMemory{name, size});
+    if ( !m_sharedMemory->valid() ){
+        std::cerr << "[ShmRing] Could not " << ((0 == capacity) ? "attach to " : "create ") << name << std::endl;
+        return;
+    }
+
+    uintptr_t const base{reinterpret_cast<uintptr_t>(m_sharedMemory->data())};
+    void *aligned{reinterpret_cast<void *>((base + ALIGNMENT - 1) & ~(ALIGNMENT - 1))};
+    if ( 0 < capacity ){
+        Header *header = new (aligned) Header;
+        header->capacity = (capacity + 7) & ~7u;
+        header->reserved.store(0);
+        header->sequence.store(0);
+        header->isConsumerSleeping.store(0);
+        header->tail.store(0);
+        // Unwritten length words must read as zero, also in a segment left over by an earlier run.
+        std::memset(reinterpret_cast<char *>(header) + sizeof(Header), 0, header->capacity);
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = RING_MAGIC;
+    }
+    Header *header = static_cast<Header *>(aligned);
+    if ( RING_MAGIC != header->magic ){
+        std::cerr << "[ShmRing] " << name << " is not a ring" << std::endl;
+        return;
+    }
+    m_header = header;
+    m_records = reinterpret_cast<char *>(header) + sizeof(Header);
+}
+
+bool ShmRing::isValid() const noexcept
+{
+    return nullptr != m_header;
+}
+
+bool ShmRing::push(const char *data, std::size_t size) noexcept
+{
+    if ( nullptr == m_header ){
+        return false;
+    }
+    uint64_t const capacity{m_header->capacity};
+    std::size_t const needed{recordSize(size)};
+    uint64_t head;
+    std::size_t position;
+    std::size_t toEnd;
+    bool isWrapping;
+    // Reserve the record (and the rest of the ring if it does not fit before the end);
+    // tail is read before head so that head - tail never underflows.
+    do {
+        uint64_t const tail{m_header->tail.load(std::memory_order_acquire)};
+        head = m_header->reserved.load(std::memory_order_relaxed);
+        position = static_cast<std::size_t>(head % capacity);
+        toEnd = static_cast<std::size_t>(capacity) - position;
+        isWrapping = needed > toEnd;
+        if ( needed > capacity || capacity - (head - tail) < needed + (isWrapping ? toEnd : 0) ){
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!m_header->reserved.compare_exchange_weak(head, head + (isWrapping ? toEnd : 0) + needed, std::memory_order_relaxed));
+
+    // Commit by writing the length word last; the consumer stops at the first
+    // record that is not committed yet, so records of slower producers are not skipped.
+    if ( isWrapping ){
+        storeLength(m_records + position, WRAP_MARKER);
+        head += toEnd;
+    }
+    char *record = m_records + (head % capacity);
+    std::memcpy(record + sizeof(uint32_t), data, size);
+    storeLength(record, COMMITTED | static_cast<uint32_t>(size));
+
+    // Pairs with the consumer announcing its sleep before re-checking the ring.
+    m_header->sequence.fetch_add(1, std::memory_order_seq_cst);
+    if ( 0 != m_header->isConsumerSleeping.load(std::memory_order_seq_cst) ){
+        ::syscall(SYS_futex, &m_header->sequence, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+    return true;
+}
+
+uint32_t ShmRing::drain(const std::function<void(const char *, std::size_t)> &onRecord) noexcept
+{
+    if ( nullptr == m_header ){
+        return 0;
+    }
+    uint64_t const capacity{m_header->capacity};
+    uint64_t tail{m_header->tail.load(std::memory_order_relaxed)};
+    uint64_t const reserved{m_header->reserved.load(std::memory_order_acquire)};
+    uint32_t count{0};
+    while (tail < reserved) {
+        char *record = m_records + (tail % capacity);
+        uint32_t const length{loadLength(record)};
+        if ( 0 == length ){
+            break;
+        }
+        // Consumed bytes are zeroed before tail hands them back to the producers.
+        if ( WRAP_MARKER == length ){
+            std::memset(record, 0, sizeof(uint32_t));
+            tail += capacity - (tail % capacity);
+            continue;
+        }
+        uint32_t const size{length & ~COMMITTED};
+        onRecord(record + sizeof(uint32_t), size);
+        std::memset(record, 0, recordSize(size));
+        tail += recordSize(size);
+        count += 1;
+    }
+    m_header->tail.store(tail, std::memory_order_release);
+    return count;
+}
+
+void ShmRing::waitForData(std::chrono::microseconds timeout) noexcept
+{
+    if ( nullptr == m_header ){
+        std::this_thread::sleep_for(timeout);
+        return;
+    }
+    // Polling only pays off when the producer runs on another core.
+    static bool const isSpinning{std::thread::hardware_concurrency() > 1};
+    auto const spinUntil = std::chrono::steady_clock::now() + SPIN_TIME;
+    while (isSpinning && isEmpty() && std::chrono::steady_clock::now() < spinUntil) {
+    }
+    if ( !isEmpty() ){
+        return;
+    }
+
+    uint32_t const sequence{m_header->sequence.load(std::memory_order_seq_cst)};
+    m_header->isConsumerSleeping.store(1, std::memory_order_seq_cst);
+    if ( isEmpty() ){
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000);
+        ts.tv_nsec = static_cast<long>((timeout.count() % 1000000) * 1000);
+        ::syscall(SYS_futex, &m_header->sequence, FUTEX_WAIT, sequence, &ts, nullptr, 0);
+    }
+    m_header->isConsumerSleeping.store(0, std::memory_order_relaxed);
+}
+
+uint64_t ShmRing::dropped() const noexcept
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+bool ShmRing::isEmpty() const noexcept
+{
+    uint64_t const tail{m_header->tail.load(std::memory_order_relaxed)};
+    return 0 == loadLength(m_records + (tail % m_header->capacity));
+}
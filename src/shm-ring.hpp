@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SHM_RING_HPP
+#define SHM_RING_HPP
+
+#include "cluon-complete.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+/**
+ * Multi-producer, single consumer ring of variable sized records (OD4
+ * envelopes) in a cluon::SharedMemory segment. Push and drain are lock-free;
+ * an idle consumer sleeps on a futex in the segment, so a producer only
+ * enters the kernel when the consumer is asleep. Linux only.
+ *
+ * Any number of threads and processes may push: a producer reserves its
+ * record with a compare and swap on the write index and commits it by
+ * writing the record's length word last. Only one thread of one process may
+ * drain a ring, though; a second consumer would take records from the first.
+ */
+class ShmRing {
+   private:
+    ShmRing(const ShmRing &) = delete;
+    ShmRing(ShmRing &&)      = delete;
+    ShmRing &operator=(const ShmRing &) = delete;
+    ShmRing &operator=(ShmRing &&) = delete;
+
+   public:
+    /**
+     * @param name Name of the shared memory segment.
+     * @param capacity Bytes of the ring to create, or 0 to attach to an existing ring.
+     */
+    ShmRing(const std::string &name, uint32_t capacity) noexcept;
+    ~ShmRing() = default;
+
+   public:
+    bool isValid() const noexcept;
+
+    /**
+     * Appends one record; fails without blocking when the ring is full.
+     * Safe to call from several producers at once.
+     */
+    bool push(const char *data, std::size_t size) noexcept;
+
+    /**
+     * Hands every committed record to onRecord, in the order they were
+     * reserved; stops at a record that is still being written. Single consumer only.
+     *
+     * @return Number of records drained.
+     */
+    uint32_t drain(const std::function<void(const char *, std::size_t)> &onRecord) noexcept;
+
+    /**
+     * Blocks until a record is available or the timeout expired; spins
+     * briefly before going to sleep.
+     */
+    void waitForData(std::chrono::microseconds timeout) noexcept;
+
+    uint64_t dropped() const noexcept;
+
+   private:
+    struct Header;
+
+    bool isEmpty() const noexcept;
+
+   private:
+    std::unique_ptr<cluon::SharedMemory> m_sharedMemory;
+    Header *m_header{nullptr};
+    char *m_records{nullptr};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+#endif
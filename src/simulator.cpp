@@ -0,0 +1,378 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "simulator.hpp"
+#include "entity-states.hpp"
+#include "episode.hpp"
+#include "fixed-rate-scheduler.hpp"
+#include "metrics-server.hpp"
+#include "replay.hpp"
+#include "thread-pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+// The whole text as a number that T can hold; false for typos, trailing characters or out of range values.
+bool toNumber(const std::string &text, double &value) noexcept
+{
+    try {
+        std::size_t end{0};
+        value = std::stod(text, &end);
+        return end == text.size();
+    }
+    catch (const std::invalid_argument &) {}
+    catch (const std::out_of_range &) {}
+    return false;
+}
+
+bool toNumber(const std::string &text, float &value) noexcept
+{
+    double number{0.0};
+    bool const isValid{toNumber(text, number) && std::fabs(number) <= std::numeric_limits<float>::max()};
+    value = static_cast<float>(number);
+    return isValid;
+}
+
+template <typename T>
+bool toNumber(const std::string &text, T &value) noexcept
+{
+    static_assert(std::is_integral<T>::value && sizeof(T) < sizeof(long long), "integral options only");
+    try {
+        std::size_t end{0};
+        long long const number{std::stoll(text, &end)};
+        if ( end != text.size() || number < std::numeric_limits<T>::min() || number > std::numeric_limits<T>::max() ){
+            return false;
+        }
+        value = static_cast<T>(number);
+        return true;
+    }
+    catch (const std::invalid_argument &) {}
+    catch (const std::out_of_range &) {}
+    return false;
+}
+
+// Reads --<name> into value if given; false, after saying so, if it is not a valid number.
+template <typename T>
+bool numberOption(std::map<std::string, std::string> &commandlineArguments, const std::string &name, T &value) noexcept
+{
+    if ( (0 == commandlineArguments.count(name)) || toNumber(commandlineArguments[name], value) ){
+        return true;
+    }
+    std::cerr << "The " << name << " should be " << (std::is_integral<T>::value ? "an integer" : "a number")
+              << " that fits its range, not '" << commandlineArguments[name] << "'..." << std::endl;
+    return false;
+}
+
+// <name>.rec becomes <name>-<cid>.rec
+std::string recordingName(const std::string &filename, uint16_t cid)
+{
+    std::string::size_type const extension{filename.rfind(".rec")};
+    std::string const stem{(std::string::npos != extension && extension + 4 == filename.size()) ? filename.substr(0, extension) : filename};
+    return stem + "-" + std::to_string(cid) + ".rec";
+}
+
+// Prometheus text exposition of all episodes; the scheduler is null in lockstep mode.
+std::string renderMetrics(const std::vector<std::unique_ptr<Episode>> &episodes, const FixedRateScheduler *scheduler)
+{
+    std::stringstream out;
+    auto family = [&out](const char *name, const char *type, const char *help){
+        out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    };
+    auto perEpisode = [&](const char *name, const char *type, const char *help, std::function<uint64_t(Episode &)> value){
+        family(name, type, help);
+        for (auto const &episode : episodes) {
+            out << name << "{cid=\"" << episode->cid() << "\"} " << value(*episode) << "\n";
+        }
+    };
+    auto perMessageType = [&](const char *name, const char *help, bool isSent){
+        family(name, "counter", help);
+        for (auto const &episode : episodes) {
+            for (uint32_t type = 0; type < EpisodeMetrics::MESSAGE_TYPES; type++) {
+                auto const &counters = isSent ? episode->metrics().sent : episode->metrics().received;
+                out << name << "{cid=\"" << episode->cid() << "\",type=\"" << EpisodeMetrics::nameOf(type) << "\"} "
+                    << counters[type].load(std::memory_order_relaxed) << "\n";
+            }
+        }
+    };
+
+    if ( nullptr != scheduler ){
+        std::chrono::duration<double> const period = scheduler->period();
+        family("ball_sim_tick_period_seconds", "gauge", "Configured wall clock tick period.");
+        out << "ball_sim_tick_period_seconds " << period.count() << "\n";
+        family("ball_sim_scheduler_overruns_total", "counter", "Ticks that started after their deadline.");
+        out << "ball_sim_scheduler_overruns_total " << scheduler->overruns() << "\n";
+        family("ball_sim_scheduler_skipped_ticks_total", "counter", "Ticks skipped to catch up after overruns.");
+        out << "ball_sim_scheduler_skipped_ticks_total " << scheduler->skippedTicks() << "\n";
+    }
+    perEpisode("ball_sim_ticks_total", "counter", "Simulation ticks run.",
+        [](Episode &e){ return e.metrics().ticks.load(std::memory_order_relaxed); });
+    perMessageType("ball_sim_messages_received_total", "Envelopes received per message type.", false);
+    perMessageType("ball_sim_messages_sent_total", "Envelopes published per message type.", true);
+    perEpisode("ball_sim_unknown_sender_messages_total", "counter", "Frames, preview points and complete flags from untracked sender stamps.",
+        [](Episode &e){ return e.metrics().unknownSenders.load(std::memory_order_relaxed); });
+    perEpisode("ball_sim_filtered_messages_total", "counter", "Envelopes dropped undecoded because no handler subscribed to their type.",
+        [](Episode &e){ return e.metrics().filtered.load(std::memory_order_relaxed); });
+    perEpisode("ball_sim_coalesced_messages_total", "counter", "Envelopes skipped because a newer one of the same type and sender arrived in the same drain of the socket.",
+        [](Episode &e){ return e.metrics().coalesced.load(std::memory_order_relaxed); });
+    perEpisode("ball_sim_delta_skipped_messages_total", "counter", "Target frames not republished because the target did not move since its last frame.",
+        [](Episode &e){ return e.metrics().deltaSkipped.load(std::memory_order_relaxed); });
+    perEpisode("ball_sim_delta_saved_bytes_total", "counter", "Bytes of the target frames not republished.",
+        [](Episode &e){ return e.metrics().deltaSavedBytes.load(std::memory_order_relaxed); });
+    perEpisode("ball_sim_unhandled_messages_total", "counter", "Envelopes of a type the episode does not handle.",
+        [](Episode &e){ return e.metrics().unhandledTypes.load(std::memory_order_relaxed); });
+    perEpisode("ball_sim_captures_total", "counter", "Targets captured by any drone.",
+        [](Episode &e){ return e.metrics().captures.load(std::memory_order_relaxed); });
+    perEpisode("ball_sim_ball_alerts_total", "counter", "Times a drone came within the alert radius of a ball.",
+        [](Episode &e){ return e.metrics().ballAlerts.load(std::memory_order_relaxed); });
+    perEpisode("ball_sim_lockstep_pending_steps", "gauge", "Released lockstep steps not yet run.",
+        [](Episode &e){ return e.queueDepths().pendingSteps; });
+    perEpisode("ball_sim_recorder_backlog", "gauge", "Envelopes queued for the recorder but not yet written.",
+        [](Episode &e){ return e.queueDepths().recorderBacklog; });
+    perEpisode("ball_sim_recorder_dropped_total", "counter", "Envelopes the recorder dropped because its queue was full.",
+        [](Episode &e){ return e.queueDepths().recorderDropped; });
+    perEpisode("ball_sim_shm_dropped_total", "counter", "Envelopes dropped because the outgoing shared memory ring was full.",
+        [](Episode &e){ return e.queueDepths().shmDropped; });
+    perEpisode("ball_sim_receive_batches_total", "counter", "recvmmsg calls that returned datagrams.",
+        [](Episode &e){ return e.queueDepths().receiveBatches; });
+    perEpisode("ball_sim_receive_truncated_total", "counter", "Datagrams dropped because they were longer than the receive buffer.",
+        [](Episode &e){ return e.queueDepths().receiveTruncated; });
+    perEpisode("ball_sim_send_errors_total", "counter", "Datagrams that failed to send, the rest of their tick was still sent, and messages that failed to encode.",
+        [](Episode &e){ return e.queueDepths().sendErrors; });
+    return out.str();
+}
+}
+
+int32_t runSimulator(std::map<std::string, std::string> &commandlineArguments, const Scenario &scenario) noexcept
+{
+    int32_t retCode{1};
+
+    // Tick rate of the simulation loop in Hz.
+    float freq{10.0f};
+    if ( !numberOption(commandlineArguments, "freq", freq) ){
+        return retCode;
+    }
+    if ( freq <= 0.0f || freq > 1000.0f ){
+        std::cerr << "The freq should be in the range (0, 1000] Hz..." << std::endl;
+        return retCode;
+    }
+
+    // Lockstep mode: advance one tick per UAV frame (default) or per StepRequest (--lockstep=step)
+    EpisodeOptions options;
+    options.dt = 1.0f / freq;
+    options.isLockstep = (0 != commandlineArguments.count("lockstep"));
+    options.isStepOnFrame = options.isLockstep && "step" != commandlineArguments["lockstep"];
+    bool const isLockstep{options.isLockstep};
+
+    // Pack all outputs of a tick into one datagram (subscribers must unpack every envelope)
+    options.isSingleDatagram = (0 != commandlineArguments.count("single-datagram"));
+
+    // Co-located controllers can exchange envelopes over shared memory rings next to UDP
+    options.isSharedMemory = (0 != commandlineArguments.count("shm"));
+
+    // High rate pose streams: decode only the newest frame per drone of every per-tick drain
+    options.isCoalescing = (0 != commandlineArguments.count("coalesce"));
+
+    // Print and publish (LogMessage) the latency histograms every N seconds besides at shutdown
+    if ( !numberOption(commandlineArguments, "latency-report", options.latencyReportPeriod) ){
+        return retCode;
+    }
+
+    // Publish the poses of every ball in the next N ticks as LocalPath (default 0, off)
+    if ( !numberOption(commandlineArguments, "look-ahead", options.lookAhead) ){
+        return retCode;
+    }
+
+    // Seconds to wait for the first UAV pose or start message before ticking anyway
+    double startTimeout{5.0};
+    if ( !numberOption(commandlineArguments, "start-timeout", startTimeout) ){
+        return retCode;
+    }
+    if ( startTimeout < 0.0 ){
+        std::cerr << "The start-timeout should not be negative..." << std::endl;
+        return retCode;
+    }
+
+    // Pack all target and ball positions into one EntityStates per tick instead of a Frame each
+    options.isBulk = (0 != commandlineArguments.count("bulk"));
+    if ( options.isBulk && scenarioExtent(scenario) > ENTITY_STATES_MAX_POSITION ){
+        std::cerr << "The scenario reaches " << scenarioExtent(scenario) << " m, but --bulk quantizes positions to +-"
+                  << ENTITY_STATES_MAX_POSITION << " m..." << std::endl;
+        return retCode;
+    }
+
+    // Publish targets when they move, plus all of them every N simulated ms (default 1000, 0 every tick)
+    if ( !numberOption(commandlineArguments, "keyframe", options.keyframePeriod) ){
+        return retCode;
+    }
+
+    // Record all sent and received envelopes; batch mode writes one file per episode (<name>-<cid>.rec)
+    std::string const recFile{(0 != commandlineArguments.count("rec")) ? commandlineArguments["rec"] : ""};
+
+    // Swarm mode: sender stamps of the UAV frames to track, each drone gets its own TargetFoundState
+    std::vector<uint32_t> &droneStamps = options.droneStamps;
+    if ( (0 != commandlineArguments.count("drones")) ) {
+        droneStamps.clear();
+        // stringtoolbox::split() returns nothing for a single stamp without comma.
+        std::stringstream stamps{commandlineArguments["drones"]};
+        std::string stamp;
+        uint32_t droneStamp{0};
+        while (std::getline(stamps, stamp, ',')) {
+            if ( !toNumber(stamp, droneStamp) ){
+                std::cerr << "The drones should be comma separated sender stamps, not '" << commandlineArguments["drones"] << "'..." << std::endl;
+                return retCode;
+            }
+            droneStamps.push_back(droneStamp);
+        }
+    }
+    std::vector<uint32_t> sortedStamps{droneStamps};
+    std::sort(sortedStamps.begin(), sortedStamps.end());
+    bool isValidSwarm{!sortedStamps.empty() && std::adjacent_find(sortedStamps.begin(), sortedStamps.end()) == sortedStamps.end()};
+    for (auto const &target : scenario.targets) {
+        isValidSwarm = isValidSwarm && !std::binary_search(sortedStamps.begin(), sortedStamps.end(), target.senderStamp);
+    }
+    for (auto const &ball : scenario.balls) {
+        isValidSwarm = isValidSwarm && !std::binary_search(sortedStamps.begin(), sortedStamps.end(), ball.senderStamp);
+    }
+    if ( !isValidSwarm ){
+        std::cerr << "The drones should use unique sender stamps that are not used by targets or balls..." << std::endl;
+        return retCode;
+    }
+
+    // Offline regression run of recorded UAV inputs, no network involved
+    if ( (0 != commandlineArguments.count("replay")) ) {
+        options.recFile = recFile;
+        return runReplay(commandlineArguments, scenario, options);
+    }
+
+    if ( (0 == commandlineArguments.count("cid")) ) {
+        std::cerr << "You should include the cid to start communicate in OD4Session" << std::endl;
+        return retCode;
+    }
+    uint16_t cid{0};
+    if ( !numberOption(commandlineArguments, "cid", cid) ){
+        return retCode;
+    }
+
+    // Batch mode: host several independent episodes on the consecutive CIDs cid .. cid + episodes - 1
+    uint16_t nEpisodes{1};
+    if ( !numberOption(commandlineArguments, "episodes", nEpisodes) ){
+        return retCode;
+    }
+    if ( nEpisodes < 1 || cid + nEpisodes - 1 > 254 ){
+        std::cerr << "The episodes should use CIDs within [1, 254]..." << std::endl;
+        return retCode;
+    }
+    // Port of the Prometheus endpoint, checked before any episode starts
+    uint16_t metricsPort{0};
+    if ( !numberOption(commandlineArguments, "metrics-port", metricsPort) ){
+        return retCode;
+    }
+    uint32_t nThreads{std::min<uint32_t>(nEpisodes, std::max<uint32_t>(1, std::thread::hardware_concurrency()))};
+    int32_t threads{1};
+    if ( !numberOption(commandlineArguments, "threads", threads) ){
+        return retCode;
+    }
+    if ( (0 != commandlineArguments.count("threads")) ) {
+        nThreads = static_cast<uint32_t>(std::max(1, threads));
+    }
+
+    // Episodes are ticked by the workers; the main thread joins in for the wall clock ticks.
+    ThreadPool pool{isLockstep ? nThreads : nThreads - 1};
+    auto onStep = [&pool](Episode &episode){
+        pool.post([&episode](){ episode.runPendingSteps(); });
+    };
+
+    // Interface to running OpenDaVINCI sessions; here, you can send and receive messages.
+    std::vector<std::unique_ptr<Episode>> episodes;
+    for (uint16_t i = 0; i < nEpisodes; i++) {
+        EpisodeOptions episodeOptions{options};
+        if ( !recFile.empty() ){
+            episodeOptions.recFile = (1 == nEpisodes) ? recFile : recordingName(recFile, static_cast<uint16_t>(cid + i));
+        }
+        episodes.emplace_back(new Episode(static_cast<uint16_t>(cid + i), scenario, episodeOptions, onStep));
+    }
+    auto isRunning = [&episodes](){
+        return std::all_of(episodes.begin(), episodes.end(), [](const std::unique_ptr<Episode> &episode){ return episode->isRunning(); });
+    };
+
+    // Readiness handshake: tick as soon as every episode received a UAV pose or a start
+    // message, or after the timeout; lockstep episodes only advance on UAV input anyway.
+    auto const waitStart = std::chrono::steady_clock::now();
+    if ( !isLockstep ){
+        auto const deadline = waitStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(startTimeout));
+        auto isReady = [&episodes](){
+            return std::all_of(episodes.begin(), episodes.end(), [](const std::unique_ptr<Episode> &episode){ return episode->isReady(); });
+        };
+        while (isRunning() && !isReady() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    for (auto &episode : episodes) {
+        episode->announceStart();
+    }
+    std::chrono::duration<double, std::milli> const waited = std::chrono::steady_clock::now() - waitStart;
+    std::cout <<" Ready after " << waited.count() << " ms" << std::endl;
+    std::cout <<" Start ball simulation with " << nEpisodes << " episode(s) of " << droneStamps.size() << " drone(s) on " << nThreads << " thread(s)..." << std::endl;
+
+    FixedRateScheduler scheduler{freq};
+
+    // Prometheus endpoint, e.g. curl http://localhost:9100/metrics; local only unless --metrics-address says otherwise
+    std::unique_ptr<MetricsServer> metricsServer;
+    if ( (0 != commandlineArguments.count("metrics-port")) ) {
+        std::string const address{(0 != commandlineArguments.count("metrics-address")) ? commandlineArguments["metrics-address"] : "127.0.0.1"};
+        FixedRateScheduler const *wallClock{isLockstep ? nullptr : &scheduler};
+        metricsServer.reset(new MetricsServer{address, metricsPort, [&episodes, wallClock](){ return renderMetrics(episodes, wallClock); }});
+        if ( !metricsServer->isRunning() ){
+            std::cerr << "Could not serve metrics on " << address << ":" << metricsPort << "..." << std::endl;
+        }
+    }
+
+    while (isRunning()) {
+        if ( isLockstep ){
+            // Episodes are stepped by the workers as soon as their UAV side released a step
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        else{
+            // Wait for the absolute deadline of the next tick; skipped ticks are integrated into this one
+            uint32_t const periods = scheduler.waitForNextTick();
+            pool.parallelFor(episodes.size(), [&episodes, periods](std::size_t i){ episodes[i]->tick(periods); });
+        }
+    }
+    pool.stop();
+
+    if ( !isLockstep ){
+        scheduler.printStatistics(std::cout);
+    }
+    for (auto &episode : episodes) {
+        episode->printStatistics(std::cout);
+    }
+
+    retCode = 0;
+    return retCode;
+}
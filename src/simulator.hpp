@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SIMULATOR_HPP
+#define SIMULATOR_HPP
+
+#include "scenario.hpp"
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+/**
+ * Runs the episodes of the given scenario as configured on the command line
+ * (cid, freq, lockstep, episodes, threads) until the session is terminated,
+ * or replays a recording offline with --replay.
+ *
+ * @return Exit code for main().
+ */
+int32_t runSimulator(std::map<std::string, std::string> &commandlineArguments, const Scenario &scenario) noexcept;
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "target-grid.hpp"
+#include "distance-kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+TargetGrid::TargetGrid(float cellSize) noexcept
+    : m_inverseCellSize{1.0f / cellSize}
+{
+}
+
+void TargetGrid::build(const std::vector<Waypoint> &positions, const std::vector<uint32_t> &ids) noexcept
+{
+    uint32_t const nEntries = static_cast<uint32_t>(positions.size());
+
+    // About two buckets per entry keeps the chains short.
+    uint32_t nBuckets{16};
+    while (nBuckets < 2 * nEntries) {
+        nBuckets *= 2;
+    }
+    m_bucketMask = nBuckets - 1;
+
+    // Counting sort of the entries by bucket; m_slots holds the bucket of
+    // each entry until it is placed, m_bucketStart[b] the next free slot of b.
+    m_slots.resize(nEntries);
+    m_bucketStart.assign(nBuckets + 1, 0);
+    for (uint32_t i = 0; i < nEntries; i++) {
+        m_slots[i] = bucketOf(cellOf(positions[i].x), cellOf(positions[i].y));
+        m_bucketStart[m_slots[i] + 1] += 1;
+    }
+    for (uint32_t b = 0; b < nBuckets; b++) {
+        m_bucketStart[b + 1] += m_bucketStart[b];
+    }
+
+    m_xs.assign(nEntries, std::numeric_limits<float>::quiet_NaN());
+    m_ys.resize(nEntries);
+    m_ids.resize(nEntries);
+    m_indexedXs.resize(nEntries);
+    m_hits.resize(nEntries);
+    for (uint32_t i = 0; i < nEntries; i++) {
+        uint32_t const slot = m_bucketStart[m_slots[i]]++;
+        m_indexedXs[slot] = positions[i].x;
+        m_ys[slot] = positions[i].y;
+        m_ids[slot] = ids[i];
+        m_slots[i] = slot;
+    }
+    // Placing advanced every start to the end of its bucket; shift them back.
+    for (uint32_t b = nBuckets; b > 0; b--) {
+        m_bucketStart[b] = m_bucketStart[b - 1];
+    }
+    m_bucketStart[0] = 0;
+    m_nActive = 0;
+}
+
+void TargetGrid::setActive(uint32_t entry, bool isActive) noexcept
+{
+    uint32_t const slot = m_slots[entry];
+    bool const wasActive = !std::isnan(m_xs[slot]);
+    m_xs[slot] = isActive ? m_indexedXs[slot] : std::numeric_limits<float>::quiet_NaN();
+    if ( isActive != wasActive ){
+        m_nActive = isActive ? m_nActive + 1 : m_nActive - 1;
+    }
+}
+
+void TargetGrid::query(float x, float y, float radius, std::vector<uint32_t> &result) const noexcept
+{
+    if ( 0 == m_nActive ){
+        return;
+    }
+    int32_t const cx0 = cellOf(x - radius);
+    int32_t const cx1 = cellOf(x + radius);
+    int32_t const cy0 = cellOf(y - radius);
+    int32_t const cy1 = cellOf(y + radius);
+    float const radius2 = radius * radius;
+
+    // Distinct cells may share a bucket; visit each bucket only once.
+    constexpr uint32_t MAX_VISITED{16};
+    constexpr uint32_t MAX_LINEAR{32};
+    if ( m_ids.size() <= MAX_LINEAR || static_cast<int64_t>(cx1 - cx0 + 1) * (cy1 - cy0 + 1) > MAX_VISITED ){
+        // Too few entries, or a radius spanning too many cells, for the index to pay off.
+        appendWithin(x, y, radius2, 0, static_cast<uint32_t>(m_ids.size()), result);
+        return;
+    }
+
+    uint32_t visited[MAX_VISITED];
+    uint32_t nVisited{0};
+    for (int32_t cy = cy0; cy <= cy1; cy++) {
+        for (int32_t cx = cx0; cx <= cx1; cx++) {
+            uint32_t const bucket = bucketOf(cx, cy);
+            if ( std::find(visited, visited + nVisited, bucket) != visited + nVisited ){
+                continue;
+            }
+            visited[nVisited++] = bucket;
+            appendWithin(x, y, radius2, m_bucketStart[bucket], m_bucketStart[bucket + 1], result);
+        }
+    }
+}
+
+void TargetGrid::appendWithin(float x, float y, float radius2, uint32_t begin, uint32_t end, std::vector<uint32_t> &result) const noexcept
+{
+    if ( begin == end ){
+        return;
+    }
+    uint32_t const nHits = withinRadius(x, y, &m_xs[begin], &m_ys[begin], radius2, end - begin, m_hits.data());
+    for (uint32_t i = 0; i < nHits; i++) {
+        result.push_back(m_ids[begin + m_hits[i]]);
+    }
+}
+
+uint32_t TargetGrid::size() const noexcept
+{
+    return m_nActive;
+}
+
+int32_t TargetGrid::cellOf(float v) const noexcept
+{
+    float const cell = std::floor(v * m_inverseCellSize);
+    float const limit = static_cast<float>(std::numeric_limits<int32_t>::max() / 2);
+    return static_cast<int32_t>(std::max(-limit, std::min(limit, cell)));
+}
+
+uint32_t TargetGrid::bucketOf(int32_t cx, int32_t cy) const noexcept
+{
+    uint32_t const h = (static_cast<uint32_t>(cx) * 73856093u) ^ (static_cast<uint32_t>(cy) * 19349663u);
+    return h & m_bucketMask;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TARGET_GRID_HPP
+#define TARGET_GRID_HPP
+
+#include "scenario.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Uniform grid over target positions for sub-linear proximity queries.
+ * Cells are hashed into a power-of-two number of buckets, and the entries
+ * of a bucket are stored contiguously (x, y, id arrays sorted by bucket),
+ * so a query only runs the distance kernel over the few buckets around the
+ * query point.
+ *
+ * The grid indexes every position a target can take once; entries are then
+ * switched on and off in place, so moving a target costs two setActive()
+ * calls instead of a rebuild. Inactive entries keep their slot with x set to
+ * NaN, which the distance kernel never reports.
+ */
+class TargetGrid {
+   private:
+    TargetGrid(const TargetGrid &) = delete;
+    TargetGrid(TargetGrid &&)      = delete;
+    TargetGrid &operator=(const TargetGrid &) = delete;
+    TargetGrid &operator=(TargetGrid &&) = delete;
+
+   public:
+    explicit TargetGrid(float cellSize) noexcept;
+    ~TargetGrid() = default;
+
+   public:
+    /**
+     * Indexes entry i at positions[i], reported as ids[i] by query(); all
+     * entries start inactive.
+     */
+    void build(const std::vector<Waypoint> &positions, const std::vector<uint32_t> &ids) noexcept;
+
+    /**
+     * Includes entry i in or excludes it from queries; O(1).
+     */
+    void setActive(uint32_t entry, bool isActive) noexcept;
+
+    /**
+     * Appends the ids of all active entries within radius of (x, y).
+     */
+    void query(float x, float y, float radius, std::vector<uint32_t> &result) const noexcept;
+
+    // Number of active entries.
+    uint32_t size() const noexcept;
+
+   private:
+    int32_t cellOf(float v) const noexcept;
+    uint32_t bucketOf(int32_t cx, int32_t cy) const noexcept;
+    void appendWithin(float x, float y, float radius2, uint32_t begin, uint32_t end, std::vector<uint32_t> &result) const noexcept;
+
+   private:
+    float m_inverseCellSize;
+    uint32_t m_bucketMask{0};
+    std::vector<uint32_t> m_bucketStart{};
+    std::vector<float> m_xs{};
+    std::vector<float> m_ys{};
+    std::vector<uint32_t> m_ids{};
+    // Per slot the indexed x, restored on activation; per entry its slot.
+    std::vector<float> m_indexedXs{};
+    std::vector<uint32_t> m_slots{};
+    uint32_t m_nActive{0};
+    // Scratch space of the distance kernel; queries are not thread-safe.
+    mutable std::vector<uint32_t> m_hits{};
+};
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "thread-pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(uint32_t numberOfThreads) noexcept
+{
+    for (uint32_t i = 0; i < numberOfThreads; i++) {
+        m_workers.emplace_back([this](){ work(); });
+    }
+}
+
+ThreadPool::~ThreadPool() noexcept
+{
+    stop();
+}
+
+void ThreadPool::post(std::function<void()> task) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lck(m_tasksMutex);
+        if ( m_isStopped ){
+            return;
+        }
+        m_tasks.push_back(std::move(task));
+    }
+    m_tasksCondition.notify_one();
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)> &task) noexcept
+{
+    if ( count <= 1 || m_workers.empty() ){
+        for (std::size_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    // Workers and the calling thread pull indices until all are taken.
+    std::atomic<std::size_t> next{0};
+    std::mutex doneMutex;
+    std::condition_variable doneCondition;
+    std::size_t helpersDone{0};
+    auto runIndices = [&next, count, &task](){
+        for (std::size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            task(i);
+        }
+    };
+
+    std::size_t const helpers = std::min<std::size_t>(m_workers.size(), count - 1);
+    std::size_t posted{0};
+    for (; posted < helpers; posted++) {
+        std::lock_guard<std::mutex> lck(m_tasksMutex);
+        if ( m_isStopped ){
+            break;
+        }
+        m_tasks.push_back([&runIndices, &doneMutex, &doneCondition, &helpersDone](){
+            runIndices();
+            std::lock_guard<std::mutex> doneLck(doneMutex);
+            helpersDone += 1;
+            doneCondition.notify_one();
+        });
+    }
+    m_tasksCondition.notify_all();
+
+    runIndices();
+
+    std::unique_lock<std::mutex> lck(doneMutex);
+    doneCondition.wait(lck, [&helpersDone, posted](){ return helpersDone == posted; });
+}
+
+void ThreadPool::stop() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lck(m_tasksMutex);
+        m_isStopped = true;
+        m_tasks.clear();
+    }
+    m_tasksCondition.notify_all();
+    for (auto &worker : m_workers) {
+        if ( worker.joinable() ){
+            worker.join();
+        }
+    }
+}
+
+uint32_t ThreadPool::size() const noexcept
+{
+    return static_cast<uint32_t>(m_workers.size());
+}
+
+void ThreadPool::work() noexcept
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lck(m_tasksMutex);
+            m_tasksCondition.wait(lck, [this](){ return m_isStopped || !m_tasks.empty(); });
+            if ( m_isStopped ){
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
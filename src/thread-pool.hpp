@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of worker threads processing posted tasks in FIFO order.
+ */
+class ThreadPool {
+   private:
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool(ThreadPool &&)      = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    ThreadPool &operator=(ThreadPool &&) = delete;
+
+   public:
+    explicit ThreadPool(uint32_t numberOfThreads) noexcept;
+    ~ThreadPool() noexcept;
+
+   public:
+    /**
+     * Queues a task; tasks posted after stop() are dropped.
+     */
+    void post(std::function<void()> task) noexcept;
+
+    /**
+     * Runs task(0) .. task(count - 1) on the workers and the calling thread
+     * and returns when all of them have finished.
+     */
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)> &task) noexcept;
+
+    /**
+     * Joins the workers; queued but not yet started tasks are discarded.
+     */
+    void stop() noexcept;
+
+    uint32_t size() const noexcept;
+
+   private:
+    void work() noexcept;
+
+   private:
+    std::mutex m_tasksMutex{};
+    std::condition_variable m_tasksCondition{};
+    std::deque<std::function<void()>> m_tasks{};
+    bool m_isStopped{false};
+    std::vector<std::thread> m_workers{};
+};
+
+#endif
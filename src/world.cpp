@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "world.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Phase switches due within this many seconds happen in the current tick.
+constexpr double PHASE_TOLERANCE{1.0e-6};
+// Steps whose dt differs by less than this many seconds continue the look-ahead.
+constexpr float LOOK_AHEAD_DT_TOLERANCE{1.0e-7f};
+
+// Moves a target to waypoint, which hides it at or past its endWaypoint.
+void moveTarget(World &world, uint32_t target, uint32_t waypoint) noexcept
+{
+    Scenario const &scenario = world.scenario;
+    TargetSpec const &spec = scenario.targets[target];
+    if ( 0 != world.isTargetActive[target] ){
+        world.targetGrid.setActive(world.targetEntries[target] + world.targetWaypoints[target] - spec.firstWaypoint, false);
+    }
+    bool const isActive = waypoint < spec.endWaypoint;
+    if ( isActive ){
+        world.targetGrid.setActive(world.targetEntries[target] + waypoint - spec.firstWaypoint, true);
+    }
+    world.targetWaypoints[target] = waypoint;
+    world.targetPositions[target] = isActive ? scenario.waypoints[waypoint] : scenario.hidden;
+    world.isTargetActive[target] = isActive ? 1 : 0;
+    world.isTargetMoved[target] = 1;
+}
+
+Waypoint ballPosition(const Scenario &scenario, const BallState &ball) noexcept
+{
+    BallPhase const &phase = scenario.phases[ball.phase];
+    return phase.isVisible ? Waypoint{phase.ox + phase.dx * ball.sweep.s, phase.oy + phase.dy * ball.sweep.s} : scenario.hidden;
+}
+
+void advancePhase(const Scenario &scenario, const BallSpec &spec, BallState &ball, float dt) noexcept
+{
+    BallPhase const &phase = scenario.phases[ball.phase];
+    ball.phaseTime += static_cast<double>(dt);
+    if ( phase.duration > 0.0f && ball.phaseTime + PHASE_TOLERANCE >= static_cast<double>(phase.duration) ){
+        ball.phaseTime = std::max(0.0, ball.phaseTime - static_cast<double>(phase.duration));
+        ball.phase = (ball.phase + 1 < spec.endPhase) ? ball.phase + 1 : spec.firstPhase;
+    }
+}
+
+// One more tick of a moving ball after state; returns the pose published in it.
+Waypoint predictBall(const Scenario &scenario, const BallSpec &spec, BallState &state, float dt) noexcept
+{
+    advanceSweep(spec, state.sweep, dt);
+    Waypoint const pose = ballPosition(scenario, state);
+    advancePhase(scenario, spec, state, dt);
+    return pose;
+}
+
+void updateLookAhead(World &world, float dt, bool isMoving) noexcept
+{
+    Scenario const &scenario = world.scenario;
+    uint32_t const n = world.lookAhead;
+    bool const isContinued = world.isLookAheadValid && isMoving && std::fabs(dt - world.lookAheadDt) < LOOK_AHEAD_DT_TOLERANCE;
+    if ( isContinued ){
+        // The ball is where the first entry predicted; it is replaced by one tick past the last.
+        uint32_t const last = (world.lookAheadHead + n - 1) % n;
+        for (std::size_t i = 0; i < scenario.balls.size(); i++) {
+            BallState state = world.lookAheadStates[i * n + last];
+            world.lookAheadPoses[i * n + world.lookAheadHead] = predictBall(scenario, scenario.balls[i], state, world.lookAheadDt);
+            world.lookAheadStates[i * n + world.lookAheadHead] = state;
+        }
+        world.lookAheadHead = (world.lookAheadHead + 1) % n;
+        return;
+    }
+
+    // After a reset, a change of dt or while held (the phases go on), predict from scratch.
+    for (std::size_t i = 0; i < scenario.balls.size(); i++) {
+        BallState state = world.balls[i];
+        for (uint32_t k = 0; k < n; k++) {
+            world.lookAheadPoses[i * n + k] = predictBall(scenario, scenario.balls[i], state, dt);
+            world.lookAheadStates[i * n + k] = state;
+        }
+    }
+    world.lookAheadHead = 0;
+    world.lookAheadDt = dt;
+    world.isLookAheadValid = true;
+}
+
+// Smallest squared length of r + u * dr for u in [0, 1].
+float closestApproach2(float rx, float ry, float drx, float dry) noexcept
+{
+    float const dr2 = drx * drx + dry * dry;
+    float const u = (dr2 > 0.0f) ? std::min(std::max(-(rx * drx + ry * dry) / dr2, 0.0f), 1.0f) : 0.0f;
+    float const x = rx + u * drx;
+    float const y = ry + u * dry;
+    return x * x + y * y;
+}
+
+// Closest approach of two points moving linearly from p0, b0 to p1, b1 in the same time.
+float sweptDistance2(const Waypoint &p0, const Waypoint &p1, const Waypoint &b0, const Waypoint &b1) noexcept
+{
+    return closestApproach2(p0.x - b0.x, p0.y - b0.y, (p1.x - p0.x) - (b1.x - b0.x), (p1.y - p0.y) - (b1.y - b0.y));
+}
+
+/**
+ * Whether the drone came within radius2 of the ball between the last check
+ * and now. Both move linearly at constant speed; a ball that turned at a
+ * sweep limit in between is followed to that limit and back.
+ */
+bool isPassedBetweenTicks(const World &world, uint32_t drone, const DroneInput &pos, uint32_t ball, float radius2) noexcept
+{
+    Scenario const &scenario = world.scenario;
+    BallState const &from = world.checkedBalls[ball];
+    BallState const &to = world.balls[ball];
+    if ( from.phase != to.phase ){
+        return false;
+    }
+    BallPhase const &phase = scenario.phases[to.phase];
+    BallSpec const &spec = scenario.balls[ball];
+    auto const at = [&phase](float s){ return Waypoint{phase.ox + phase.dx * s, phase.oy + phase.dy * s}; };
+    Waypoint const p0{world.checkedDrones[drone].x, world.checkedDrones[drone].y};
+    Waypoint const p1{pos.x, pos.y};
+
+    if ( from.sweep.direction * to.sweep.direction > 0.0f ){
+        return sweptDistance2(p0, p1, at(from.sweep.s), at(to.sweep.s)) <= radius2;
+    }
+    float const limit = (from.sweep.direction > 0.0f) ? spec.sweepMax : spec.sweepMin;
+    float const before = std::fabs(limit - from.sweep.s);
+    float const after = std::fabs(limit - to.sweep.s);
+    float const f = (before + after > 0.0f) ? before / (before + after) : 0.0f;
+    Waypoint const pf{p0.x + f * (p1.x - p0.x), p0.y + f * (p1.y - p0.y)};
+    return sweptDistance2(p0, pf, at(from.sweep.s), at(limit)) <= radius2
+        || sweptDistance2(pf, p1, at(limit), at(to.sweep.s)) <= radius2;
+}
+
+void updateBallAlert(World &world, uint32_t drone, uint32_t ball, bool isClose) noexcept
+{
+    uint8_t &isCloseToBall = world.isCloseToBall[drone * world.balls.size() + ball];
+    if ( isClose != (0 != isCloseToBall) ){
+        isCloseToBall = isClose ? 1 : 0;
+        world.alertEvents.push_back(BallAlertEvent{drone, ball, isClose, false});
+    }
+}
+}
+
+World::World(const Scenario &scenario_, uint32_t nDrones_, uint32_t lookAhead_) noexcept
+    : scenario{scenario_}
+    , nDrones{nDrones_}
+    , lookAhead{lookAhead_}
+    , targetWaypoints(scenario_.targets.size())
+    , isTargetActive(scenario_.targets.size())
+    , targetGrid{scenario_.captureRadius}
+    , targetEntries(scenario_.targets.size())
+    , balls(scenario_.balls.size())
+    , nTargetFoundTimers(nDrones_)
+    , isCloseToBall(nDrones_ * scenario_.balls.size())
+    , checkedDrones(nDrones_)
+    , checkedBalls(scenario_.balls.size())
+    , targetPositions(scenario_.targets.size())
+    , isTargetMoved(scenario_.targets.size())
+    , ballPositions(scenario_.balls.size())
+    , ballVelocities(scenario_.balls.size())
+    , isChpadFound(nDrones_)
+    , lookAheadStates(scenario_.balls.size() * lookAhead_)
+    , lookAheadPoses(scenario_.balls.size() * lookAhead_)
+{
+    std::vector<Waypoint> entryPositions;
+    std::vector<uint32_t> entryTargets;
+    for (std::size_t i = 0; i < scenario.targets.size(); i++) {
+        TargetSpec const &spec = scenario.targets[i];
+        targetEntries[i] = static_cast<uint32_t>(entryPositions.size());
+        for (uint32_t w = spec.firstWaypoint; w < spec.endWaypoint; w++) {
+            entryPositions.push_back(scenario.waypoints[w]);
+            entryTargets.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    targetGrid.build(entryPositions, entryTargets);
+    // At most an entering and a leaving event per drone and ball, so steps never allocate.
+    alertEvents.reserve(2 * isCloseToBall.size());
+    resetWorld(*this);
+}
+
+void resetWorld(World &world) noexcept
+{
+    Scenario const &scenario = world.scenario;
+    for (std::size_t i = 0; i < scenario.targets.size(); i++) {
+        moveTarget(world, static_cast<uint32_t>(i), scenario.targets[i].firstWaypoint);
+    }
+    for (std::size_t i = 0; i < scenario.balls.size(); i++) {
+        BallSpec const &spec = scenario.balls[i];
+        world.balls[i] = BallState{initialSweep(spec), spec.firstPhase, 0.0};
+        world.ballPositions[i] = ballPosition(scenario, world.balls[i]);
+        world.ballVelocities[i] = Velocity{0.0f, 0.0f};
+    }
+    std::fill(world.isCloseToBall.begin(), world.isCloseToBall.end(), 0);
+    std::fill(world.nTargetFoundTimers.begin(), world.nTargetFoundTimers.end(), 0);
+    std::fill(world.isChpadFound.begin(), world.isChpadFound.end(), 0);
+    world.isLookAheadValid = false;
+    world.isCheckValid = false;
+}
+
+void step(World &world, const Inputs &inputs, float dt) noexcept
+{
+    Scenario const &scenario = world.scenario;
+    std::fill(world.isTargetMoved.begin(), world.isTargetMoved.end(), 0);
+    if ( inputs.isTaskCompleted ){
+        resetWorld(world);
+    }
+    world.alertEvents.clear();
+    world.captures = 0;
+
+    // A captured target moves on to its next waypoint or disappears. Like the
+    // original maze loop, at most one target is captured per tick: the first
+    // drone in the list that reaches any scores the first of them in the scenario.
+    for (uint32_t drone = 0; drone < world.nDrones; drone++) {
+        DroneInput const &pos = inputs.drones[drone];
+        world.capturedTargets.clear();
+        world.targetGrid.query(pos.x, pos.y, scenario.captureRadius, world.capturedTargets);
+        if ( !world.capturedTargets.empty() ){
+            uint32_t const target = *std::min_element(world.capturedTargets.begin(), world.capturedTargets.end());
+            world.nTargetFoundTimers[drone] += 1;
+            world.captures = 1;
+            moveTarget(world, target, world.targetWaypoints[target] + 1);
+            break;
+        }
+    }
+
+    // Visible balls (alert radius) and the charging pad in one pass of the distance kernel.
+    world.proximity.clear();
+    world.proximityBalls.clear();
+    bool const isAlertChecked = scenario.ballAlertRadius > 0.0f && inputs.previewDistance > -1.0f;
+    float const alertRadius = scenario.ballAlertRadius + scenario.uavRadius + scenario.ballRadius;
+    if ( isAlertChecked ){
+        for (std::size_t i = 0; i < scenario.balls.size(); i++) {
+            BallPhase const &phase = scenario.phases[world.balls[i].phase];
+            if ( phase.isVisible ){
+                world.proximity.add(phase.ox + phase.dx * world.balls[i].sweep.s, phase.oy + phase.dy * world.balls[i].sweep.s, alertRadius);
+                world.proximityBalls.push_back(static_cast<uint32_t>(i));
+            }
+        }
+    }
+    uint32_t const nBallEntries = world.proximity.size();
+    if ( scenario.hasChpad ){
+        world.proximity.add(scenario.chpad.x, scenario.chpad.y, scenario.chpadRadius);
+    }
+    world.proximityHits.resize(world.proximity.size());
+
+    for (uint32_t drone = 0; drone < world.nDrones; drone++) {
+        DroneInput const &pos = inputs.drones[drone];
+        uint32_t const nHits = withinRadii(pos.x, pos.y, world.proximity.xs.data(), world.proximity.ys.data(),
+            world.proximity.radii2.data(), world.proximity.size(), world.proximityHits.data());
+
+        uint32_t hit{0};
+        for (uint32_t entry = 0; entry < nBallEntries; entry++) {
+            bool const isClose = (hit < nHits && world.proximityHits[hit] == entry);
+            hit += isClose ? 1 : 0;
+            uint32_t const ball = world.proximityBalls[entry];
+            bool const wasClose = 0 != world.isCloseToBall[drone * world.balls.size() + ball];
+            if ( !isClose && !wasClose && world.isCheckValid
+                 && isPassedBetweenTicks(world, drone, pos, ball, world.proximity.radii2[entry]) ){
+                world.alertEvents.push_back(BallAlertEvent{drone, ball, true, true});
+                world.alertEvents.push_back(BallAlertEvent{drone, ball, false, true});
+            }
+            else{
+                updateBallAlert(world, drone, ball, isClose);
+            }
+        }
+        bool const isChpadFound = scenario.hasChpad && hit < nHits && world.proximityHits[hit] == nBallEntries;
+        world.isChpadFound[drone] = isChpadFound ? 1 : 0;
+    }
+    if ( isAlertChecked ){
+        std::copy(inputs.drones.begin(), inputs.drones.end(), world.checkedDrones.begin());
+        std::copy(world.balls.begin(), world.balls.end(), world.checkedBalls.begin());
+    }
+    world.isCheckValid = isAlertChecked;
+
+    bool const isMoving = inputs.previewDistance > scenario.ballHoldDistance;
+    for (std::size_t i = 0; i < scenario.balls.size(); i++) {
+        BallSpec const &spec = scenario.balls[i];
+        BallState &ball = world.balls[i];
+        if ( isMoving ){
+            advanceSweep(spec, ball.sweep, dt);
+        }
+
+        // Published at the phase of this tick, the phase switch applies from the next one.
+        BallPhase const &phase = scenario.phases[ball.phase];
+        world.ballPositions[i] = ballPosition(scenario, ball);
+        bool const isVisiblyMoving = isMoving && phase.isVisible;
+        world.ballVelocities[i] = isVisiblyMoving ? Velocity{phase.dx * ball.sweep.v, phase.dy * ball.sweep.v} : Velocity{0.0f, 0.0f};
+        advancePhase(scenario, spec, ball, dt);
+    }
+    if ( world.lookAhead > 0 ){
+        updateLookAhead(world, dt, isMoving);
+    }
+
+    world.time += static_cast<double>(dt);
+    world.ticks += 1;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2018  Christian Berger
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WORLD_HPP
+#define WORLD_HPP
+
+#include "ball-kinematics.hpp"
+#include "distance-kernel.hpp"
+#include "scenario.hpp"
+#include "target-grid.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Position of one drone at the start of a tick.
+ */
+struct DroneInput {
+    float x;
+    float y;
+};
+
+/**
+ * Everything step() reads besides the world itself.
+ */
+struct Inputs {
+    // One entry per drone of the world.
+    std::vector<DroneInput> drones{};
+    // Latest preview distance of the UAV, -1 if none was received.
+    float previewDistance{-1.0f};
+    // Starts the next step from the initial state.
+    bool isTaskCompleted{false};
+};
+
+/**
+ * A drone entered (isClose) or left the alert radius of a ball. A drone that
+ * passed through the radius between two ticks gets an entering and a leaving
+ * event in the same step, both marked isBetweenTicks.
+ */
+struct BallAlertEvent {
+    uint32_t drone;
+    uint32_t ball;
+    bool isClose;
+    bool isBetweenTicks;
+};
+
+struct BallState {
+    SweepState sweep;
+    uint32_t phase;
+    // Seconds spent in the current phase.
+    double phaseTime;
+};
+
+struct Velocity {
+    float vx;
+    float vy;
+};
+
+/**
+ * Complete state of one simulation; no I/O, so it can be stepped directly by
+ * benchmarks, fuzzers and optimisers. After step() the output fields hold
+ * what the tick publishes.
+ */
+struct World {
+    /**
+     * @param scenario Map to simulate; must outlive the world.
+     * @param nDrones Number of drones, i.e. the size of Inputs::drones.
+     * @param lookAhead Number of future ball poses predicted per tick, 0 for none.
+     */
+    World(const Scenario &scenario, uint32_t nDrones, uint32_t lookAhead = 0) noexcept;
+
+    const Scenario &scenario;
+    uint32_t const nDrones;
+    uint32_t const lookAhead;
+    // Simulated time in seconds and number of steps since the start.
+    double time{0.0};
+    uint64_t ticks{0};
+
+    // Current waypoint per target, endWaypoint once captured at the last one.
+    std::vector<uint32_t> targetWaypoints;
+    std::vector<uint8_t> isTargetActive;
+    // Index over every waypoint of every target, of which the current ones
+    // are active; target t's waypoint w is entry targetEntries[t] + w - firstWaypoint.
+    TargetGrid targetGrid;
+    std::vector<uint32_t> targetEntries;
+    std::vector<BallState> balls;
+    // Per drone: found targets and whether it is close to every ball (drone * nBalls + ball).
+    std::vector<int16_t> nTargetFoundTimers;
+    std::vector<uint8_t> isCloseToBall;
+    // Drones and balls at the last alert check, to test the motion since then;
+    // invalid after a reset or a step without alert checks.
+    std::vector<DroneInput> checkedDrones;
+    std::vector<BallState> checkedBalls;
+    bool isCheckValid{false};
+
+    // Outputs of the last step.
+    std::vector<Waypoint> targetPositions;
+    // Targets that moved in the last step (captured, or all after a reset).
+    std::vector<uint8_t> isTargetMoved;
+    std::vector<Waypoint> ballPositions;
+    // Zero while a ball is hidden or held.
+    std::vector<Velocity> ballVelocities;
+    std::vector<uint16_t> isChpadFound;
+    std::vector<BallAlertEvent> alertEvents{};
+    uint32_t captures{0};
+
+    // Look-ahead: per ball, the states and published poses of the next lookAhead
+    // ticks of the last dt, assuming the ball keeps moving. Ring buffers of
+    // lookAhead entries (ball * lookAhead + slot) starting at lookAheadHead;
+    // while the ball moves at a constant dt, each step extends them by one tick.
+    std::vector<BallState> lookAheadStates;
+    std::vector<Waypoint> lookAheadPoses;
+    uint32_t lookAheadHead{0};
+    float lookAheadDt{0.0f};
+    bool isLookAheadValid{false};
+
+    // Scratch space of step().
+    std::vector<uint32_t> capturedTargets{};
+    EntityStore proximity{};
+    std::vector<uint32_t> proximityBalls{};
+    std::vector<uint32_t> proximityHits{};
+};
+
+/**
+ * Puts all targets and balls back to their initial state.
+ */
+void resetWorld(World &world) noexcept;
+
+/**
+ * Advances the world by one tick of dt seconds.
+ */
+void step(World &world, const Inputs &inputs, float dt) noexcept;
+
+/**
+ * @return Pose the ball will be published at after k + 1 more ticks of the
+ *         last step's dt, for k < world.lookAhead.
+ */
+inline const Waypoint &lookAheadPose(const World &world, std::size_t ball, uint32_t k) noexcept
+{
+    return world.lookAheadPoses[ball * world.lookAhead + (world.lookAheadHead + k) % world.lookAhead];
+}
+
+#endif